@@ -0,0 +1,138 @@
+/********************************************
+ * asyncLog - Asynchronous logging
+ * Every process writes its log lines into its
+ * own ring in the shared memory log area.  A
+ * writer thread in oss drains all the rings
+ * and writes them out in large blocks to the
+ * log file and the screen, so logging never
+ * opens a file or makes a syscall in the
+ * simulation's critical sections.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * asyncLog .h file for project
+ ********************************************/
+#ifndef ASYNCLOG_H
+#define ASYNCLOG_H
+
+#include <string>
+#include <atomic>
+#include <string.h>
+#include "spscRing.h"
+#include "pageTable.h"
+
+// Log levels - each one includes the ones above it
+enum LogLevel { LOGLEVEL_ERROR, LOGLEVEL_INFO, LOGLEVEL_VERBOSE, LOGLEVEL_TRACE };
+const char* const logLevelNames[] = { "error", "info", "verbose", "trace" };
+
+// Returns the level with this name, or -1 if there is none
+inline int GetLogLevelFromName(const std::string& strName)
+{
+    for(int i = LOGLEVEL_ERROR; i <= LOGLEVEL_TRACE; i++)
+        if(strName == logLevelNames[i])
+            return i;
+    return -1;
+}
+
+// A log line is split into chunks that each fit one ring slot.
+// The first and last chunks of a line are flagged so the writer
+// only ever writes out whole lines, even if a process was killed
+// part way through one
+const int logChunkText = 124;
+struct LogChunk {
+    unsigned short length;
+    unsigned char startOfLine;
+    unsigned char endOfLine;
+    char text[logChunkText];
+};
+
+// Chunks each process can have waiting for the writer
+const unsigned int logRingSize = 512;
+// Times a process waits for room in a full ring before the
+// line is dropped
+const int logFullSpinCount = 2000;
+
+struct LogChannel {
+    spscRing<LogChunk, logRingSize> ring;
+    std::atomic<unsigned int> dropped;  // Lines lost to a full ring
+};
+
+// One channel per PCB slot, then one for oss.  The channels are
+// laid out in the shared segment with everything else sized at
+// run time
+struct LogArea {
+    std::atomic<unsigned int> doorbell;     // futex word the writer sleeps on
+    std::atomic<unsigned int> writerSleeping;
+    int channelCount;
+    relativeArray<LogChannel> channel;
+};
+
+// The channel oss logs on
+inline int GetLogOssChannel(const LogArea* logArea)
+{
+    return logArea->channelCount - 1;
+}
+
+// Only call before any process is logging
+inline void InitLogArea(LogArea* logArea)
+{
+    logArea->doorbell = 0;
+    logArea->writerSleeping = 0;
+    for(int i = 0; i < logArea->channelCount; i++)
+    {
+        logArea->channel[i].ring.init();
+        logArea->channel[i].dropped = 0;
+    }
+}
+
+// Wakes the writer if it is asleep
+inline void WakeLogWriter(LogArea* logArea)
+{
+    if(logArea->writerSleeping.load())
+    {
+        logArea->doorbell++;
+        futexWake(&logArea->doorbell);
+    }
+}
+
+// Queues one line for the writer.  If the ring stays full the
+// whole line is dropped and counted.  Returns false if dropped
+inline bool LogWrite(LogArea* logArea, int nChannel, const char* text, size_t length)
+{
+    LogChannel& channel = logArea->channel[nChannel];
+    const unsigned int nChunks = length / logChunkText + 1;
+    if(nChunks > logRingSize)
+    {
+        channel.dropped++;
+        return false;
+    }
+
+    // Back-pressure - give the writer a chance to catch up
+    for(int nSpin = 0; logRingSize - channel.ring.size() < nChunks; nSpin++)
+    {
+        if(nSpin == logFullSpinCount)
+        {
+            channel.dropped++;
+            return false;
+        }
+        WakeLogWriter(logArea);
+        sched_yield();
+    }
+
+    LogChunk chunk;
+    for(unsigned int i = 0; i < nChunks; i++)
+    {
+        chunk.length = (i + 1 < nChunks) ? logChunkText : length % logChunkText;
+        chunk.startOfLine = (i == 0);
+        chunk.endOfLine = (i + 1 == nChunks);
+        memcpy(chunk.text, text + i * logChunkText, chunk.length);
+        channel.ring.push(chunk);
+    }
+
+    // Don't let the ring get close to full before the writer runs
+    if(channel.ring.size() > logRingSize / 2)
+        WakeLogWriter(logArea);
+    return true;
+}
+
+#endif // ASYNCLOG_H
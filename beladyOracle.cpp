@@ -0,0 +1,138 @@
+/********************************************
+ * beladyOracle - Belady's optimal replacement
+ * Replays a recorded trace evicting the page
+ * whose next use is furthest away.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * beladyOracle .cpp file for project
+ ********************************************/
+
+#include <set>
+#include <unordered_map>
+#include <climits>
+#include "pageTable.h"
+#include "beladyOracle.h"
+
+using namespace std;
+
+// One reference in the order it was made.  page is a page id
+// unique to one lifetime of one process.  For an exit it is the
+// lifetime that ended
+struct OracleReference {
+    int page;
+    short procIndex;
+    short type;
+};
+
+void RunBeladyOracle(traceReader& trace, int nFrames, ReplayStats& stats)
+{
+    stats = ReplayStats(processesMax);
+
+    // Pass 1 - number the pages.  A PCB slot is reused after its
+    // process exits, so each lifetime of a slot gets its own pages.
+    // Only pages that are used get an id, so the ids stay compact
+    // however many lifetimes and pages there are
+    vector<OracleReference> refs;
+    vector<int> lifetime(processesMax);
+    for(int i = 0; i < processesMax; i++)
+        lifetime[i] = i;
+    int nLifetimes = processesMax;
+    unordered_map<uint64_t, int> pageIds;       // Lifetime and page to id
+    vector<vector<int> > lifetimePages(nLifetimes);  // Ids of each lifetime's pages
+
+    TraceRecord rec;
+    trace.rewind();
+    while(trace.next(rec))
+    {
+        if(rec.procIndex < 0 || rec.procIndex >= processesMax)
+        {
+            stats.nSegFaults++;
+            continue;
+        }
+        if(rec.type == TRACE_EXIT)
+        {
+            stats.nProcessExits++;
+            OracleReference ref = { lifetime[rec.procIndex], (short)rec.procIndex, TRACE_EXIT };
+            refs.push_back(ref);
+            lifetime[rec.procIndex] = nLifetimes++;
+            lifetimePages.push_back(vector<int>());
+            continue;
+        }
+        stats.nAccesses++;
+        stats.processAccesses[rec.procIndex]++;
+        if(rec.address >= (uint)processSize)
+        {
+            stats.nSegFaults++;
+            continue;
+        }
+        const int nLifetime = lifetime[rec.procIndex];
+        const uint64_t nKey = (uint64_t)nLifetime * pageCount + GetPageNumber(rec.address);
+        auto id = pageIds.find(nKey);
+        if(id == pageIds.end())
+        {
+            id = pageIds.insert(make_pair(nKey, (int)pageIds.size())).first;
+            lifetimePages[nLifetime].push_back(id->second);
+        }
+        OracleReference ref = { id->second, (short)rec.procIndex, (short)rec.type };
+        refs.push_back(ref);
+    }
+    trace.rewind();
+
+    // Pass 2 - walk backwards to find where each page is next used.
+    // Pages never used again are next used at LONG_MAX
+    const long nRefs = refs.size();
+    vector<long> nextUse(nRefs);
+    const size_t nPages = pageIds.size();
+    vector<long> seenAt(nPages, LONG_MAX);
+    for(long i = nRefs - 1; i >= 0; i--)
+    {
+        if(refs[i].type == TRACE_EXIT)
+            continue;
+        nextUse[i] = seenAt[refs[i].page];
+        seenAt[refs[i].page] = i;
+    }
+
+    // Pass 3 - replay.  The resident pages are ordered by next use,
+    // so the victim is always the last one
+    set< pair<long, int> > resident;
+    vector<long> residentKey(nPages, -1);   // -1 if not resident
+    vector<bool> dirty(nPages, false);
+    for(long i = 0; i < nRefs; i++)
+    {
+        const OracleReference& ref = refs[i];
+        if(ref.type == TRACE_EXIT)
+        {
+            // The process' pages leave memory without an eviction
+            for(int nPage : lifetimePages[ref.page])
+                if(residentKey[nPage] >= 0)
+                {
+                    resident.erase(make_pair(residentKey[nPage], nPage));
+                    residentKey[nPage] = -1;
+                }
+            continue;
+        }
+
+        if(residentKey[ref.page] >= 0)
+            resident.erase(make_pair(residentKey[ref.page], ref.page));
+        else
+        {
+            stats.nFaults++;
+            stats.processFaults[ref.procIndex]++;
+            if((int)resident.size() >= nFrames)
+            {
+                int nVictim = prev(resident.end())->second;
+                resident.erase(prev(resident.end()));
+                residentKey[nVictim] = -1;
+                stats.nEvictions++;
+                if(dirty[nVictim])
+                    stats.nWritebacks++;
+            }
+            dirty[ref.page] = false;
+        }
+        if(ref.type == TRACE_WRITE)
+            dirty[ref.page] = true;
+        residentKey[ref.page] = nextUse[i];
+        resident.insert(make_pair(nextUse[i], ref.page));
+    }
+}
@@ -0,0 +1,41 @@
+/********************************************
+ * beladyOracle - Belady's optimal replacement
+ * Works out how many faults a recorded trace
+ * would take if every eviction picked the page
+ * used furthest in the future.  No real policy
+ * can do better, so it is the yardstick the
+ * replacement policies are measured against.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * beladyOracle .h file for project
+ ********************************************/
+#ifndef BELADYORACLE_H
+#define BELADYORACLE_H
+
+#include <vector>
+#include "traceFile.h"
+
+// Fault counts for one run over a trace - overall and per PCB slot
+struct ReplayStats {
+    long nAccesses = 0;
+    long nFaults = 0;
+    long nSegFaults = 0;
+    long nEvictions = 0;
+    long nWritebacks = 0;
+    long nProcessExits = 0;
+    uint64_t nLastSimTime = 0;
+    std::vector<long> processAccesses;
+    std::vector<long> processFaults;
+
+    ReplayStats(int nProcesses = 0)
+        : processAccesses(nProcesses, 0), processFaults(nProcesses, 0) {}
+};
+
+// Runs OPT over the whole trace with nFrames frames shared by all
+// processes, the way the pager shares them.  Next uses are found
+// in one backward pass and the resident pages are kept ordered by
+// next use, so this is O(n log nFrames)
+void RunBeladyOracle(traceReader& trace, int nFrames, ReplayStats& stats);
+
+#endif // BELADYORACLE_H
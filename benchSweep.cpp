@@ -0,0 +1,400 @@
+/********************************************
+ * benchSweep - Parameter Sweep Benchmark
+ * Runs the in-process engine over every
+ * combination of frames, processes, replacement
+ * policy, write ratio and workload asked for, several
+ * runs at a time, and writes one CSV or JSON
+ * row per run for capacity planning.  Each run
+ * is a forked child so they can't disturb each
+ * other.
+ *
+ * Brett Huffman
+ * benchSweep CPP file for oss project
+ ********************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/wait.h>
+#include "pageReplacement.h"
+#include "workload.h"
+#include "oss.h"
+
+using namespace std;
+
+// One point in the sweep
+struct BenchRun {
+    int nFrames;
+    int nProcesses;
+    string strPolicy;
+    float fltWriteProbability;
+    string strWorkload;
+    bool bFailed = false;       // No results - it is left out of the output
+    EngineResults results;
+};
+
+// A run in progress - its results come back over fd
+struct BenchChild {
+    pid_t pid;
+    int fd;
+    int nRun;
+};
+
+// Forward declarations
+static void show_usage(std::string);
+static bool ParseIntList(string, vector<int>&);
+static bool ParseFloatList(string, vector<float>&);
+static bool StartRun(BenchRun&, int, const OssOptions&, BenchChild&);
+static void WriteCsv(const vector<BenchRun>&, long);
+static void WriteJson(const vector<BenchRun>&, long);
+
+int main(int argc, char* argv[])
+{
+    int opt;
+    vector<int> frames = { 64, 128, 256 };
+    vector<int> processes = { 5, 10, 20 };
+    vector<string> policies = GetPageReplacementNameList();
+    vector<float> writeRatios = { 0.35f };
+    vector<string> workloads = { "uniform" };
+    long nReferences = 1000000;
+    int nJobs = max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+    unsigned int nSeed = 1;
+    bool bJson = false;
+
+    while ((opt = getopt(argc, argv, "f:hj:n:o:p:r:s:W:w:")) != -1) {
+        switch (opt) {
+            case 'h':
+                show_usage(argv[0]);
+                return EXIT_SUCCESS;
+            case 'f':
+                if(!ParseIntList(optarg, frames))
+                {
+                    errno = EINVAL;
+                    perror("ossbench: Error: Bad frame list");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'p':
+                if(!ParseIntList(optarg, processes))
+                {
+                    errno = EINVAL;
+                    perror("ossbench: Error: Bad process list");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'r':
+            {
+                string strPolicies = optarg;
+                if(strPolicies == "all")
+                    break;
+                policies.clear();
+                stringstream ss(strPolicies);
+                string strPolicy;
+                while(getline(ss, strPolicy, ','))
+                {
+                    if(!IsPageReplacementName(strPolicy))
+                    {
+                        errno = EINVAL;
+                        perror(("ossbench: Error: Unknown page replacement policy " + strPolicy).c_str());
+                        return EXIT_FAILURE;
+                    }
+                    policies.push_back(strPolicy);
+                }
+                break;
+            }
+            case 'w':
+                if(!ParseFloatList(optarg, writeRatios))
+                {
+                    errno = EINVAL;
+                    perror("ossbench: Error: Bad write ratio list");
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'W':
+            {
+                workloads.clear();
+                stringstream ss(optarg);
+                string strWorkload;
+                WorkloadParams workload;
+                while(getline(ss, strWorkload, ','))
+                {
+                    if(!ParseWorkload(strWorkload, workload))
+                    {
+                        errno = EINVAL;
+                        perror(("ossbench: Error: Unknown workload " + strWorkload).c_str());
+                        return EXIT_FAILURE;
+                    }
+                    workloads.push_back(strWorkload);
+                }
+                break;
+            }
+            case 'n':
+                nReferences = max(1L, atol(optarg));
+                break;
+            case 'j':
+                nJobs = max(1, atoi(optarg));
+                break;
+            case 's':
+                nSeed = max(1, atoi(optarg));
+                break;
+            case 'o':
+                bJson = string(optarg) == "json";
+                if(!bJson && string(optarg) != "csv")
+                {
+                    errno = EINVAL;
+                    perror("ossbench: Error: Output must be csv or json");
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                show_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    // Build the matrix
+    vector<BenchRun> runs;
+    for(int nFrames : frames)
+        for(int nProcesses : processes)
+            for(string& strPolicy : policies)
+                for(float fltWrite : writeRatios)
+                    for(string& strWorkload : workloads)
+                    {
+                        BenchRun run;
+                        run.nFrames = nFrames;
+                        run.nProcesses = nProcesses;
+                        run.strPolicy = strPolicy;
+                        run.fltWriteProbability = fltWrite;
+                        run.strWorkload = strWorkload;
+                        runs.push_back(run);
+                    }
+
+    // Every run gets the same references to make and the same seed,
+    // so rows differ only by their parameters
+    OssOptions options;
+    options.nEngineReferences = nReferences;
+    options.nEngineSeed = nSeed;
+
+    cerr << "ossbench: " << runs.size() << " runs, " << nJobs << " at a time" << endl;
+
+    // Keep nJobs runs going until they are all done
+    vector<BenchChild> children;
+    size_t nNextRun = 0;
+    size_t nDone = 0;
+    bool bSuccess = true;
+    while(nDone < runs.size())
+    {
+        while((int)children.size() < nJobs && nNextRun < runs.size())
+        {
+            BenchChild child;
+            if(!StartRun(runs[nNextRun], nNextRun, options, child))
+                return EXIT_FAILURE;
+            children.push_back(child);
+            nNextRun++;
+        }
+
+        int wstatus;
+        pid_t pid = waitpid(-1, &wstatus, 0);
+        if(pid < 0)
+        {
+            perror("ossbench: Error waiting for a run");
+            return EXIT_FAILURE;
+        }
+        for(size_t i = 0; i < children.size(); i++)
+        {
+            if(children[i].pid != pid)
+                continue;
+            BenchRun& run = runs[children[i].nRun];
+            if(!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != EXIT_SUCCESS
+                || read(children[i].fd, &run.results, sizeof(run.results)) != sizeof(run.results))
+            {
+                cerr << "ossbench: Run " << children[i].nRun << " failed - " << run.nFrames
+                     << " frames, " << run.nProcesses << " processes, " << run.strPolicy << endl;
+                run.bFailed = true;
+                bSuccess = false;
+            }
+            close(children[i].fd);
+            children.erase(children.begin() + i);
+            nDone++;
+            cerr << "ossbench: " << nDone << "/" << runs.size() << " done\r" << flush;
+            break;
+        }
+    }
+    cerr << endl;
+
+    if(bJson)
+        WriteJson(runs, nReferences);
+    else
+        WriteCsv(runs, nReferences);
+    return bSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Forks a child to do one run.  The child sends its results
+// back up a pipe
+static bool StartRun(BenchRun& run, int nRun, const OssOptions& baseOptions, BenchChild& child)
+{
+    int fds[2];
+    if(pipe(fds) == -1)
+    {
+        perror("ossbench: Could not create pipe");
+        return false;
+    }
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+        perror("ossbench: Could not fork process");
+        return false;
+    }
+    if(pid == 0)
+    {
+        close(fds[0]);
+        OssOptions options = baseOptions;
+        options.nFrames = run.nFrames;
+        options.strReplacementPolicy = run.strPolicy;
+        options.fltWriteProbability = run.fltWriteProbability;
+        options.strWorkload = run.strWorkload;
+        EngineResults results;
+        if(!RunEngine(run.nProcesses, options, results))
+            _exit(EXIT_FAILURE);
+        bool bWritten = write(fds[1], &results, sizeof(results)) == sizeof(results);
+        _exit(bWritten ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    close(fds[1]);
+    child.pid = pid;
+    child.fd = fds[0];
+    child.nRun = nRun;
+    return true;
+}
+
+// Rates worked out the same way for both outputs
+static double GetThroughput(const EngineResults& r)
+{
+    return r.nSimTimeNS > 0 ? (double)r.nMemoryAccesses * 1000000000.0 / (double)r.nSimTimeNS : 0.0;
+}
+
+static double GetRate(long nCount, const EngineResults& r)
+{
+    return r.nMemoryAccesses > 0 ? (double)nCount / (double)r.nMemoryAccesses : 0.0;
+}
+
+static void WriteCsv(const vector<BenchRun>& runs, long nReferences)
+{
+    cout << "frames,processes,policy,write_ratio,workload,references,sim_seconds,accesses_per_sim_second,"
+         << "fault_rate,segfault_rate,evictions,writebacks,latency_mean_ns,latency_p50_ns,"
+         << "latency_p90_ns,latency_p99_ns,latency_p999_ns,latency_max_ns,wall_ms" << endl;
+    cout << fixed;
+    for(const BenchRun& run : runs)
+    {
+        if(run.bFailed)
+            continue;
+        const EngineResults& r = run.results;
+        cout << r.nFrames << "," << run.nProcesses << "," << run.strPolicy << ","
+             << setprecision(2) << run.fltWriteProbability << "," << run.strWorkload << ","
+             << nReferences << ","
+             << setprecision(4) << (double)r.nSimTimeNS / 1000000000.0 << ","
+             << setprecision(2) << GetThroughput(r) << ","
+             << setprecision(6) << GetRate(r.nPageFaults, r) << "," << GetRate(r.nSegFaults, r) << ","
+             << r.nEvictions << "," << r.nWritebacks << ","
+             << setprecision(0) << r.fltLatencyMeanNS << "," << r.nLatencyP50NS << ","
+             << r.nLatencyP90NS << "," << r.nLatencyP99NS << "," << r.nLatencyP999NS << ","
+             << r.nLatencyMaxNS << "," << setprecision(3) << (double)r.nWallTimeNS / 1000000.0 << endl;
+    }
+}
+
+static void WriteJson(const vector<BenchRun>& runs, long nReferences)
+{
+    cout << "[" << endl << fixed;
+    bool bFirst = true;
+    for(size_t i = 0; i < runs.size(); i++)
+    {
+        const BenchRun& run = runs[i];
+        if(run.bFailed)
+            continue;
+        const EngineResults& r = run.results;
+        cout << (bFirst ? "" : ",\n");
+        bFirst = false;
+        cout << "  {\"frames\": " << r.nFrames
+             << ", \"processes\": " << run.nProcesses
+             << ", \"policy\": \"" << run.strPolicy << "\""
+             << ", \"write_ratio\": " << setprecision(2) << run.fltWriteProbability
+             << ", \"workload\": \"" << run.strWorkload << "\""
+             << ", \"references\": " << nReferences
+             << ", \"sim_seconds\": " << setprecision(4) << (double)r.nSimTimeNS / 1000000000.0
+             << ", \"accesses_per_sim_second\": " << setprecision(2) << GetThroughput(r)
+             << ", \"fault_rate\": " << setprecision(6) << GetRate(r.nPageFaults, r)
+             << ", \"segfault_rate\": " << GetRate(r.nSegFaults, r)
+             << ", \"evictions\": " << r.nEvictions
+             << ", \"writebacks\": " << r.nWritebacks
+             << ", \"latency_mean_ns\": " << setprecision(0) << r.fltLatencyMeanNS
+             << ", \"latency_p50_ns\": " << r.nLatencyP50NS
+             << ", \"latency_p90_ns\": " << r.nLatencyP90NS
+             << ", \"latency_p99_ns\": " << r.nLatencyP99NS
+             << ", \"latency_p999_ns\": " << r.nLatencyP999NS
+             << ", \"latency_max_ns\": " << r.nLatencyMaxNS
+             << ", \"wall_ms\": " << setprecision(3) << (double)r.nWallTimeNS / 1000000.0
+             << "}";
+    }
+    if(!bFirst)
+        cout << endl;
+    cout << "]" << endl;
+}
+
+// Splits a comma separated list of positive numbers
+static bool ParseIntList(string strList, vector<int>& values)
+{
+    values.clear();
+    stringstream ss(strList);
+    string strValue;
+    while(getline(ss, strValue, ','))
+    {
+        int nValue = atoi(strValue.c_str());
+        if(nValue < 1)
+            return false;
+        values.push_back(nValue);
+    }
+    return !values.empty();
+}
+
+static bool ParseFloatList(string strList, vector<float>& values)
+{
+    values.clear();
+    stringstream ss(strList);
+    string strValue;
+    while(getline(ss, strValue, ','))
+    {
+        float fltValue = atof(strValue.c_str());
+        if(fltValue < 0.0f || fltValue > 1.0f)
+            return false;
+        values.push_back(fltValue);
+    }
+    return !values.empty();
+}
+
+// Handle errors in input arguments by showing usage screen
+static void show_usage(std::string name)
+{
+    std::cerr << std::endl
+              << name << " - parameter sweep benchmark for the oss app" << std::endl
+              << std::endl
+              << "Usage:\t" << name << " [-h]" << std::endl
+              << "\t" << name << " [-f frames] [-p processes] [-r policies] [-w ratios]" << std::endl
+              << "\t\t[-W workloads] [-n references] [-j jobs] [-s seed] [-o csv|json]" << std::endl
+              << "Options:" << std::endl
+              << "  -h   Describe how the program should be run, then terminate" << std::endl
+              << "  -f   comma separated frame counts - default 64,128,256" << std::endl
+              << "  -p   comma separated process counts, up to 4096 - default 5,10,20" << std::endl
+              << "  -r   comma separated replacement policies, or all - default all" << std::endl
+              << "  -w   comma separated write ratios - default 0.35" << std::endl
+              << "  -W   comma separated workloads, as oss -W takes them - default uniform" << std::endl
+              << "  -n   references per run - default 1000000" << std::endl
+              << "  -j   runs at a time - default one per CPU" << std::endl
+              << "  -s   random seed every run uses - default 1" << std::endl
+              << "  -o   output format, csv or json - default csv" << std::endl
+              << std::endl << std::endl;
+}
@@ -13,6 +13,12 @@
 #include <string.h>
 #include <fstream>
 #include <stdlib.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITMAPPER_AVX2
+#endif
 
 using namespace std;
 
@@ -20,40 +26,42 @@ using namespace std;
 
 bitmapper::bitmapper(int nNumberOfBits)
 {
-    // Determine the number of characters needed
-    int nSize = nNumberOfBits / 8;
-    if(nNumberOfBits%8) // If not exactly ^8
-        nSize++;
-    _size = nSize;
-    _usageArray = new unsigned char[nSize];
-    memset(_usageArray, '\0', _size); // 0 out array
+    // Determine the number of words needed
+    _bits = MAX(nNumberOfBits, 0);
+    _nWords = (_bits + bitmapWordBits - 1) / bitmapWordBits;
+    _words = new uint64_t[_nWords];
+    memset(_words, '\0', _nWords * sizeof(uint64_t)); // 0 out array
 }
 
 // Destructor
 bitmapper::~bitmapper()
 {
-    delete [] _usageArray;
+    delete [] _words;
 }
 
 // Copy Constructor
 bitmapper::bitmapper(const bitmapper& oldObj)
 {
     // Set sizes
-    _size = oldObj._size;
-    _usageArray = new unsigned char[_size];
+    _bits = oldObj._bits;
+    _nWords = oldObj._nWords;
+    _words = new uint64_t[_nWords];
     // Copy everything over
-    memcpy(_usageArray, oldObj._usageArray, _size);
+    memcpy(_words, oldObj._words, _nWords * sizeof(uint64_t));
 }
 
 // Assignment Operator
 bitmapper& bitmapper::operator=(const bitmapper& rhs)
 {
+    if(this == &rhs)
+        return *this;
     // Delete any old object and get ready to copy rhs
-    delete [] _usageArray;
-    _size = rhs._size;
-    _usageArray = new unsigned char[_size];
+    delete [] _words;
+    _bits = rhs._bits;
+    _nWords = rhs._nWords;
+    _words = new uint64_t[_nWords];
     // Copy everything over
-    memcpy(_usageArray, rhs._usageArray, _size);
+    memcpy(_words, rhs._words, _nWords * sizeof(uint64_t));
 
     return *this;
 }
@@ -61,40 +69,165 @@ bitmapper& bitmapper::operator=(const bitmapper& rhs)
 void bitmapper::setBitmapBits(int addr, bool value)
 {
     // Check the intput
-    if(addr < 0 || addr >= _size*8)
+    if(addr < 0 || addr >= _bits)
         return;
 
     if(value)
-    {
-        // Set the bit at this point in the bitmap
-        _usageArray[addr/8] |= (1 << (7 - (addr%8)));
-    }
+        set(addr);
     else
-    {
-        // Clear the bit
-        _usageArray[addr/8] &= ~(1 << (7 - (addr%8)));
-    }
+        reset(addr);
 }
 
 bool bitmapper::getBitmapBits(int addr)
 {
         // Check the intput
-    if(addr < 0 || addr >= _size*8)
+    if(addr < 0 || addr >= _bits)
         return 0;
 
     // returns true or false based on whether value
     // is set to 1 or 0 in bitmap
-    return (_usageArray[addr/8] & (1 << (7 - (addr%8))));
+    return test(addr);
 }
 
 void bitmapper::toggleBits(int addr)
 {
     // Check the intput
-    if(addr < 0 || addr >= _size*8)
+    if(addr < 0 || addr >= _bits)
         return;
 
     // Toggle the bit at this point in the bitmap
-    _usageArray[addr/8] ^= (1 << (7 - (addr%8)));
+    _words[wordIndex(addr)] ^= wordMask(addr);
+}
+
+// findFirst - first bit at or after nStart that is set once the
+// word is xor'd with flip.  Flipping by all ones finds clear bits
+int bitmapper::findFirst(int nStart, uint64_t flip)
+{
+    if(nStart < 0)
+        nStart = 0;
+    if(nStart >= _bits)
+        return -1;
+
+    int nWord = wordIndex(nStart);
+    // Ignore the bits below nStart in its word
+    uint64_t nBits = (_words[nWord] ^ flip) & (~0ULL << (nStart % bitmapWordBits));
+    while(true)
+    {
+        if(nBits)
+        {
+            // The unused bits past the end of the last word are
+            // clear, so a search for clear bits can land on them
+            int nBit = nWord * bitmapWordBits + __builtin_ctzll(nBits);
+            return nBit < _bits ? nBit : -1;
+        }
+        if(++nWord >= _nWords)
+            return -1;
+        nBits = _words[nWord] ^ flip;
+    }
+}
+
+int bitmapper::count() const
+{
+    int nCount = 0;
+    for(int i = 0; i < _nWords; i++)
+        nCount += __builtin_popcountll(_words[i]);
+    return nCount;
+}
+
+// updateRange - the partial words at either end are masked, the
+// whole words between are filled outright
+void bitmapper::updateRange(int nFirst, int nCount, bool value)
+{
+    int nLast = MIN(nFirst + nCount, _bits);   // One past the end
+    nFirst = MAX(nFirst, 0);
+    if(nFirst >= nLast)
+        return;
+
+    int nFirstWord = wordIndex(nFirst);
+    int nLastWord = wordIndex(nLast - 1);
+    for(int i = nFirstWord; i <= nLastWord; i++)
+    {
+        uint64_t nMask = ~0ULL;
+        if(i == nFirstWord)
+            nMask &= ~0ULL << (nFirst % bitmapWordBits);
+        if(i == nLastWord && nLast % bitmapWordBits)
+            nMask &= ~0ULL >> (bitmapWordBits - nLast % bitmapWordBits);
+        if(value)
+            _words[i] |= nMask;
+        else
+            _words[i] &= ~nMask;
+    }
+}
+
+// Bulk AND/OR.  The AVX2 versions do 4 words per instruction and
+// are only called when the CPU reports AVX2, so the build needs no
+// special flags
+#ifdef BITMAPPER_AVX2
+__attribute__((target("avx2")))
+static void andWordsAVX2(uint64_t* dst, const uint64_t* src, int nWords)
+{
+    int i = 0;
+    for(; i + 4 <= nWords; i += 4)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_and_si256(a, b));
+    }
+    for(; i < nWords; i++)
+        dst[i] &= src[i];
+}
+
+__attribute__((target("avx2")))
+static void orWordsAVX2(uint64_t* dst, const uint64_t* src, int nWords)
+{
+    int i = 0;
+    for(; i + 4 <= nWords; i += 4)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(a, b));
+    }
+    for(; i < nWords; i++)
+        dst[i] |= src[i];
+}
+
+static bool HasAVX2()
+{
+    static const bool bHasAVX2 = __builtin_cpu_supports("avx2");
+    return bHasAVX2;
+}
+#endif
+
+bitmapper& bitmapper::operator&=(const bitmapper& rhs)
+{
+    int nWords = MIN(_nWords, rhs._nWords);
+#ifdef BITMAPPER_AVX2
+    if(HasAVX2())
+        andWordsAVX2(_words, rhs._words, nWords);
+    else
+#endif
+    for(int i = 0; i < nWords; i++)
+        _words[i] &= rhs._words[i];
+    // Anything past the end of rhs is ANDed with nothing
+    for(int i = nWords; i < _nWords; i++)
+        _words[i] = 0;
+    return *this;
+}
+
+bitmapper& bitmapper::operator|=(const bitmapper& rhs)
+{
+    int nWords = MIN(_nWords, rhs._nWords);
+#ifdef BITMAPPER_AVX2
+    if(HasAVX2())
+        orWordsAVX2(_words, rhs._words, nWords);
+    else
+#endif
+    for(int i = 0; i < nWords; i++)
+        _words[i] |= rhs._words[i];
+    // Don't let rhs set bits past our end
+    if(nWords == _nWords && _bits % bitmapWordBits)
+        _words[_nWords - 1] &= ~0ULL >> (bitmapWordBits - _bits % bitmapWordBits);
+    return *this;
 }
 
 void bitmapper::debugPrintBits()
@@ -103,7 +236,7 @@ void bitmapper::debugPrintBits()
     cout << "0         1         2         3         4         5         6         7         " << endl;
     cout << "01234567890123456789012345678901234567890123456789012345678901234567890123456789" << endl;
     // Print the array as bytes
-    for (int i = 0; i < _size*8; i++)
+    for (int i = 0; i < viewBits(); i++)
         cout << getBitmapBits(i);
     cout << endl;
 }
@@ -116,7 +249,7 @@ std::string bitmapper::getBitView()
     strRet.append("01234567890123456789012345678901234567890123456789012345678901234567890123456789");
     strRet.append("\n");
     // Print the array as bytes
-    for (int i = 0; i < _size*8; i++)
+    for (int i = 0; i < viewBits(); i++)
         strRet.append(getBitmapBits(i) ? "*" : " ");
     strRet.append("\n");
     return strRet;
@@ -124,34 +257,31 @@ std::string bitmapper::getBitView()
 
 std::string bitmapper::showAsTable(int BitWidth)
 {
-    if(BitWidth < 1 || _size < 1)
+    if(BitWidth < 1 || _bits < 1)
         return "";
-    char buffer[3];
+    // Row labels grow with the table, so they are built as strings
     std::string strRet =  "\t";
     int majorMarks = 10;
-    int rows = _size*8 / BitWidth;
+    int rows = viewBits() / BitWidth;
     for(int i = 0; i < BitWidth; i++)
     {
         if(i%10==0)
-            sprintf(buffer, "%d", i/10);
+            strRet.append(std::to_string(i/10));
         else
-            sprintf(buffer, "%s", " ");
-        strRet.append(buffer);
+            strRet.append(" ");
     }
     strRet.append("\n\t");
 
     for(int i = 0; i < BitWidth; i++)
     {
-        sprintf(buffer, "%d", i%10);
-        strRet.append(buffer);
+        strRet.append(std::to_string(i%10));
     }
-    for(int i = 0; i < _size*8; i++)
+    for(int i = 0; i < viewBits(); i++)
     {
         if(i%BitWidth==0)
         {
             strRet.append("\n");
-            sprintf(buffer, "%d", i/BitWidth);
-            strRet.append(buffer);
+            strRet.append(std::to_string(i/BitWidth));
             strRet.append("\t");
         }
         strRet.append(getBitmapBits(i) ? "1" : "0");
@@ -1,15 +1,21 @@
 /********************************************
  * bitmapper - Bitmap class
  * This is a special class to create & use
- * bitmaps
+ * bitmaps.  Bits are kept in 64-bit words so
+ * searches, counts and range updates work a
+ * word at a time - it is the allocator for
+ * PCB slots and physical frames.
  * (c)2021 Brett Huffman
- * 
+ *
  * Brett Huffman
  * bitmapper .h file for project
  ********************************************/
 #ifndef BITMAPPER
 #define BITMAPPER
 
+#include <string>
+#include <stdint.h>
+
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 
@@ -18,12 +24,23 @@
 #define BIT_FLIP(a, b) ((a) ^= (1ULL << (b)))
 #define BIT_CHECK(a, b) (!!((a) & (1ULL << (b))))
 
+const int bitmapWordBits = 64;
+
 class bitmapper
 {
     private:
-        int _size;
-        unsigned char* _usageArray;
-        
+        int _bits;
+        int _nWords;
+        uint64_t* _words;   // Bit n is bit n%64 of word n/64
+
+        static uint64_t wordMask(int addr) { return 1ULL << ((unsigned)addr % bitmapWordBits); }
+        static int wordIndex(int addr) { return (unsigned)addr / bitmapWordBits; }
+        // The views show whole bytes, as they did when the map
+        // was stored in bytes
+        int viewBits() const { return (_bits + 7) / 8 * 8; }
+        int findFirst(int, uint64_t);
+        void updateRange(int, int, bool);
+
     public:
 
     bitmapper(int nSize);
@@ -31,14 +48,47 @@ class bitmapper
     bitmapper(const bitmapper& oldObj);
     bitmapper& operator=(const bitmapper& rhs);
 
-    // public functions
+    // public functions - checked, so any addr is safe
     void setBitmapBits(int, bool);
     bool getBitmapBits(int);
     void toggleBits(int);
     void debugPrintBits();
     std::string getBitView();
     std::string showAsTable(int);
+
+    // Unchecked versions for hot paths - addr must be in range
+    bool test(int addr) const { return _words[wordIndex(addr)] & wordMask(addr); }
+    void set(int addr) { _words[wordIndex(addr)] |= wordMask(addr); }
+    void reset(int addr) { _words[wordIndex(addr)] &= ~wordMask(addr); }
+
+    // First set/clear bit at or after nStart, or -1 if there is none.
+    // One ctz per word, so sparse and nearly full maps are both fast
+    int findFirstSet(int nStart = 0) { return findFirst(nStart, 0); }
+    int findFirstClear(int nStart = 0) { return findFirst(nStart, ~0ULL); }
+
+    // Bits set - a popcount per word
+    int count() const;
+
+    // Set or clear nCount bits starting at nFirst
+    void setRange(int nFirst, int nCount) { updateRange(nFirst, nCount, true); }
+    void clearRange(int nFirst, int nCount) { updateRange(nFirst, nCount, false); }
+
+    // Calls fn(bit) for every set bit, lowest first
+    template <typename Fn>
+    void forEachSet(Fn fn) const
+    {
+        for(int i = 0; i < _nWords; i++)
+            for(uint64_t nWord = _words[i]; nWord; nWord &= nWord - 1)
+                fn(i * bitmapWordBits + __builtin_ctzll(nWord));
+    }
+
+    // Bulk combine with a map of the same size.  Uses AVX2 when
+    // the CPU has it
+    bitmapper& operator&=(const bitmapper& rhs);
+    bitmapper& operator|=(const bitmapper& rhs);
+
+    int size() const { return _bits; }
 };
 
 
-#endif // BITMAPPER
\ No newline at end of file
+#endif // BITMAPPER
@@ -0,0 +1,189 @@
+/********************************************
+ * eventDump - ossdump event log decoder
+ * Decodes a binary event log written by
+ * oss -E into text, CSV, or a summary of the
+ * run built from every event.
+ *
+ * Brett Huffman
+ * eventDump CPP file for oss project
+ ********************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include "eventLog.h"
+
+using namespace std;
+
+// Forward declarations
+static void show_usage(std::string);
+static void dumpText(eventLogReader&);
+static void dumpCSV(eventLogReader&);
+static void dumpSummary(eventLogReader&);
+
+int main(int argc, char* argv[])
+{
+    int opt;
+    string strFormat = "text";
+
+    while ((opt = getopt(argc, argv, "hf:")) != -1) {
+        switch (opt) {
+            case 'h':
+                show_usage(argv[0]);
+                return EXIT_SUCCESS;
+            case 'f':
+                strFormat = optarg;
+                break;
+            default:
+                show_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if(optind >= argc || (strFormat != "text" && strFormat != "csv" && strFormat != "summary"))
+    {
+        show_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    eventLogReader events;
+    if(!events.open(argv[optind]))
+    {
+        perror("ossdump: Could not open event log");
+        return EXIT_FAILURE;
+    }
+
+    if(strFormat == "csv")
+        dumpCSV(events);
+    else if(strFormat == "summary")
+        dumpSummary(events);
+    else
+        dumpText(events);
+    return EXIT_SUCCESS;
+}
+
+// Names a type or outcome, even if the file has one we don't know
+static const char* TypeName(uint8_t type)
+{
+    return type < EVENT_TYPE_COUNT ? eventTypeNames[type] : "?";
+}
+
+static const char* OutcomeName(uint8_t outcome)
+{
+    return outcome < EVENT_OUTCOME_COUNT ? eventOutcomeNames[outcome] : "?";
+}
+
+// One line per event, laid out like the oss log
+static void dumpText(eventLogReader& events)
+{
+    char buffer[128];
+    for(uint64_t i = 0; i < events.size(); i++)
+    {
+        const EventRecord& rec = events[i];
+        snprintf(buffer, sizeof(buffer), "%.6u:%.10u  %.2d  PID %-7d %-8s %-8s addr %-6u frame %d",
+            (uint)(rec.simTime / 1000000000ULL), (uint)(rec.simTime % 1000000000ULL),
+            rec.pcbIndex, rec.pid, TypeName(rec.type), OutcomeName(rec.outcome),
+            rec.address, rec.frame);
+        cout << buffer << '\n';
+    }
+}
+
+static void dumpCSV(eventLogReader& events)
+{
+    cout << "sim_time_ns,pid,pcb,event,outcome,address,frame\n";
+    for(uint64_t i = 0; i < events.size(); i++)
+    {
+        const EventRecord& rec = events[i];
+        cout << rec.simTime << ',' << rec.pid << ',' << rec.pcbIndex << ','
+             << TypeName(rec.type) << ',' << OutcomeName(rec.outcome) << ','
+             << rec.address << ',' << rec.frame << '\n';
+    }
+}
+
+// Totals for the whole run, per process slot, and the sim time
+// each page fault waited for its page
+static void dumpSummary(eventLogReader& events)
+{
+    vector<long> typeCounts(EVENT_TYPE_COUNT + 1, 0);
+    vector<long> outcomeCounts(EVENT_OUTCOME_COUNT + 1, 0);
+    map<int, long> slotAccesses, slotFaults;
+    map<int, uint64_t> faultStart;          // PCB index -> sim time of its open fault
+    long nFaultsServed = 0;
+    uint64_t nFaultWaitTotal = 0, nFaultWaitMax = 0;
+
+    for(uint64_t i = 0; i < events.size(); i++)
+    {
+        const EventRecord& rec = events[i];
+        typeCounts[min((int)rec.type, (int)EVENT_TYPE_COUNT)]++;
+        if(rec.type == EVENT_ACCESS)
+        {
+            outcomeCounts[min((int)rec.outcome, (int)EVENT_OUTCOME_COUNT)]++;
+            slotAccesses[rec.pcbIndex]++;
+            if(rec.outcome == OUTCOME_FAULT)
+            {
+                slotFaults[rec.pcbIndex]++;
+                faultStart[rec.pcbIndex] = rec.simTime;
+            }
+        }
+        else if(rec.type == EVENT_EVICTION)
+            outcomeCounts[min((int)rec.outcome, (int)EVENT_OUTCOME_COUNT)]++;
+        else if(rec.type == EVENT_PAGE_LOADED && faultStart.count(rec.pcbIndex))
+        {
+            uint64_t nWait = rec.simTime - faultStart[rec.pcbIndex];
+            faultStart.erase(rec.pcbIndex);
+            nFaultsServed++;
+            nFaultWaitTotal += nWait;
+            nFaultWaitMax = max(nFaultWaitMax, nWait);
+        }
+        else if(rec.type == EVENT_PROCESS_EXIT)
+            faultStart.erase(rec.pcbIndex);
+    }
+
+    const long nAccesses = typeCounts[EVENT_ACCESS];
+    const long nEvictions = typeCounts[EVENT_EVICTION];
+    cout << fixed << setprecision(4);
+    cout << "Events:\t\t\t\t\t" << events.size() << endl;
+    if(events.size() > 0)
+        cout << "Sim time covered:\t\t\t" << (double)(events[events.size() - 1].simTime
+            - events[0].simTime) / 1000000000.0 << " s" << endl;
+    cout << "Processes started:\t\t\t" << typeCounts[EVENT_PROCESS_START] << endl;
+    cout << "Processes exited:\t\t\t" << typeCounts[EVENT_PROCESS_EXIT] << endl;
+    cout << "Memory accesses:\t\t\t" << nAccesses << endl;
+    cout << "  hits:\t\t\t\t\t" << outcomeCounts[OUTCOME_HIT] << endl;
+    cout << "  page faults:\t\t\t\t" << outcomeCounts[OUTCOME_FAULT] << endl;
+    cout << "  seg faults:\t\t\t\t" << outcomeCounts[OUTCOME_SEGFAULT] << endl;
+    cout << "Page faults per access:\t\t\t"
+         << (nAccesses ? (double)outcomeCounts[OUTCOME_FAULT] / nAccesses : 0.0) << endl;
+    cout << "Pages loaded:\t\t\t\t" << typeCounts[EVENT_PAGE_LOADED] << endl;
+    cout << "Evictions:\t\t\t\t" << nEvictions << endl;
+    cout << "  dirty (written back):\t\t\t" << outcomeCounts[OUTCOME_DIRTY] << endl;
+    cout << "Mean fault service time:\t\t"
+         << (nFaultsServed ? (double)nFaultWaitTotal / nFaultsServed / 1000000.0 : 0.0) << " ms" << endl;
+    cout << "Max fault service time:\t\t\t" << (double)nFaultWaitMax / 1000000.0 << " ms" << endl;
+    if(typeCounts[EVENT_TYPE_COUNT] > 0)
+        cout << "Unknown events:\t\t\t\t" << typeCounts[EVENT_TYPE_COUNT] << endl;
+
+    cout << endl << "PCB\tAccesses\tFaults\tFaults/Access" << endl;
+    for(map<int, long>::iterator it = slotAccesses.begin(); it != slotAccesses.end(); ++it)
+        cout << it->first << "\t" << it->second << "\t\t" << slotFaults[it->first] << "\t"
+             << (double)slotFaults[it->first] / it->second << endl;
+}
+
+// Handle errors in input arguments by showing usage screen
+static void show_usage(std::string name)
+{
+    std::cerr << std::endl
+              << name << " - decodes an oss binary event log (oss -E)" << std::endl
+              << std::endl
+              << "Usage:\t" << name << " [-h]" << std::endl
+              << "\t" << name << " [-f text|csv|summary] eventlog" << std::endl
+              << "Options:" << std::endl
+              << "  -h   Describe how the program should be run, then terminate" << std::endl
+              << "  -f   output format - default text" << std::endl
+              << std::endl << std::endl;
+}
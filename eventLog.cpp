@@ -0,0 +1,177 @@
+/********************************************
+ * eventLog - Binary structured event log
+ * Fixed size event records appended through a
+ * memory mapped file, and the reader ossdump
+ * uses to decode them.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * eventLog .cpp file for project
+ ********************************************/
+
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "eventLog.h"
+
+using namespace std;
+
+const char* const eventTypeNames[EVENT_TYPE_COUNT] = {
+    "start", "exit", "access", "loaded", "evicted" };
+const char* const eventOutcomeNames[EVENT_OUTCOME_COUNT] = {
+    "-", "hit", "fault", "segfault", "clean", "dirty" };
+
+// The file is grown and re-mapped this much at a time
+const size_t eventLogGrowSize = 4 << 20;
+
+/***************************************************
+ * eventLogWriter
+ * *************************************************/
+eventLogWriter::eventLogWriter() : _fd(-1), _map(NULL), _mapSize(0), _nRecords(0)
+{
+}
+
+eventLogWriter::~eventLogWriter()
+{
+    close();
+}
+
+bool eventLogWriter::open(string strFile)
+{
+    _fd = ::open(strFile.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(_fd == -1)
+        return false;
+    _nRecords = 0;
+    if(!grow())
+    {
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+
+    EventLogHeader* header = (EventLogHeader*)_map;
+    memcpy(header->magic, eventLogMagic, sizeof(header->magic));
+    header->version = eventLogVersion;
+    header->recordSize = sizeof(EventRecord);
+    header->recordCount = 0;
+    return true;
+}
+
+// Extends the file and the mapping by eventLogGrowSize
+bool eventLogWriter::grow()
+{
+    size_t newSize = _mapSize + eventLogGrowSize;
+    if(ftruncate(_fd, newSize) == -1)
+        return false;
+    void* pMap = (_map == NULL)
+        ? mmap(NULL, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0)
+        : mremap(_map, _mapSize, newSize, MREMAP_MAYMOVE);
+    if(pMap == MAP_FAILED)
+        return false;
+    _map = (char*)pMap;
+    _mapSize = newSize;
+    return true;
+}
+
+bool eventLogWriter::write(uint8_t type, uint8_t outcome, uint64_t simTime, int pid,
+    int pcbIndex, uint32_t address, int frame)
+{
+    if(_fd == -1)
+        return false;
+    size_t nOffset = sizeof(EventLogHeader) + _nRecords * sizeof(EventRecord);
+    if(nOffset + sizeof(EventRecord) > _mapSize && !grow())
+        return false;
+
+    EventRecord* rec = (EventRecord*)(_map + nOffset);
+    rec->simTime = simTime;
+    rec->pid = pid;
+    rec->pcbIndex = pcbIndex;
+    rec->type = type;
+    rec->outcome = outcome;
+    rec->address = address;
+    rec->frame = frame;
+    _nRecords++;
+    return true;
+}
+
+bool eventLogWriter::close()
+{
+    if(_fd == -1)
+        return true;
+    ((EventLogHeader*)_map)->recordCount = _nRecords;
+    munmap(_map, _mapSize);
+    _map = NULL;
+    _mapSize = 0;
+
+    // Trim the unused end of the last chunk
+    bool bSuccess = ftruncate(_fd, sizeof(EventLogHeader) + _nRecords * sizeof(EventRecord)) == 0;
+    ::close(_fd);
+    _fd = -1;
+    return bSuccess;
+}
+
+/***************************************************
+ * eventLogReader
+ * *************************************************/
+eventLogReader::eventLogReader() : _map(NULL), _mapSize(0), _nRecords(0)
+{
+}
+
+eventLogReader::~eventLogReader()
+{
+    close();
+}
+
+bool eventLogReader::open(string strFile)
+{
+    close();
+    int fd = ::open(strFile.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return false;
+    struct stat st;
+    if(fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(EventLogHeader))
+    {
+        ::close(fd);
+        errno = EINVAL;
+        return false;
+    }
+    void* pMap = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(pMap == MAP_FAILED)
+        return false;
+    _map = (const char*)pMap;
+    _mapSize = st.st_size;
+
+    const EventLogHeader* header = (const EventLogHeader*)_map;
+    if(memcmp(header->magic, eventLogMagic, sizeof(eventLogMagic)) != 0
+        || header->version != eventLogVersion || header->recordSize != sizeof(EventRecord))
+    {
+        close();
+        errno = EINVAL;
+        return false;
+    }
+
+    // An unclosed log has no count and is padded with zeros - stop
+    // at the last record with a sim time, which only ever grows
+    _nRecords = (_mapSize - sizeof(EventLogHeader)) / sizeof(EventRecord);
+    if(header->recordCount > 0 && header->recordCount < _nRecords)
+        _nRecords = header->recordCount;
+    else if(header->recordCount == 0)
+        while(_nRecords > 0 && (*this)[_nRecords - 1].simTime == 0)
+            _nRecords--;
+    madvise(pMap, _mapSize, MADV_SEQUENTIAL);
+    return true;
+}
+
+void eventLogReader::close()
+{
+    if(_map != NULL)
+        munmap((void*)_map, _mapSize);
+    _map = NULL;
+    _mapSize = 0;
+    _nRecords = 0;
+}
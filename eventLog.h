@@ -0,0 +1,109 @@
+/********************************************
+ * eventLog - Binary structured event log
+ * An optional log of everything oss does to
+ * memory, one fixed size record per event, so
+ * long runs can be analysed without formatting
+ * a line of text for each event.  Records are
+ * appended through a memory mapped file and
+ * decoded offline with ossdump.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * eventLog .h file for project
+ ********************************************/
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <string>
+#include <stdint.h>
+#include <sys/types.h>
+
+enum EventType {
+    EVENT_PROCESS_START,    // A process was started in a PCB slot
+    EVENT_PROCESS_EXIT,     // A process exited and its frames were freed
+    EVENT_ACCESS,           // oss resolved a reference - see outcome
+    EVENT_PAGE_LOADED,      // A faulted page was read into a frame
+    EVENT_EVICTION,         // A page was evicted - pcbIndex/address are the victim's
+    EVENT_TYPE_COUNT
+};
+
+enum EventOutcome {
+    OUTCOME_NONE,
+    OUTCOME_HIT,            // EVENT_ACCESS - page was resident
+    OUTCOME_FAULT,          // EVENT_ACCESS - page fault, queued for I/O
+    OUTCOME_SEGFAULT,       // EVENT_ACCESS - address outside the process
+    OUTCOME_CLEAN,          // EVENT_EVICTION - nothing to write back
+    OUTCOME_DIRTY,          // EVENT_EVICTION - written back first
+    EVENT_OUTCOME_COUNT
+};
+
+extern const char* const eventTypeNames[EVENT_TYPE_COUNT];
+extern const char* const eventOutcomeNames[EVENT_OUTCOME_COUNT];
+
+struct EventRecord {
+    uint64_t simTime;       // Sim time of the event
+    int32_t pid;
+    int16_t pcbIndex;
+    uint8_t type;           // EventType
+    uint8_t outcome;        // EventOutcome
+    uint32_t address;       // Virtual address (page start for loads/evictions)
+    int32_t frame;          // Frame involved, -1 if none
+};
+static_assert(sizeof(EventRecord) == 24, "EventRecord must stay a fixed size");
+
+// On-disk header.  recordCount is filled in when the log is closed;
+// a log that was never closed is read up to its last full record
+const char eventLogMagic[8] = { 'O', 'S', 'S', 'E', 'V', 'E', 'N', 'T' };
+const uint32_t eventLogVersion = 1;
+struct EventLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t recordCount;
+};
+
+class eventLogWriter
+{
+    private:
+        int _fd;
+        char* _map;             // Mapped file - header then records
+        size_t _mapSize;
+        uint64_t _nRecords;
+
+        bool grow();
+
+    public:
+
+    eventLogWriter();
+    ~eventLogWriter();
+
+    bool open(std::string strFile);
+    bool write(uint8_t type, uint8_t outcome, uint64_t simTime, int pid,
+        int pcbIndex, uint32_t address, int frame);
+    bool close();
+    bool isOpen() { return _fd != -1; }
+    uint64_t getRecordCount() { return _nRecords; }
+};
+
+class eventLogReader
+{
+    private:
+        const char* _map;
+        size_t _mapSize;
+        uint64_t _nRecords;
+
+    public:
+
+    eventLogReader();
+    ~eventLogReader();
+
+    bool open(std::string strFile);
+    void close();
+    uint64_t size() { return _nRecords; }
+    const EventRecord& operator[](uint64_t n)
+    {
+        return ((const EventRecord*)(_map + sizeof(EventLogHeader)))[n];
+    }
+};
+
+#endif // EVENTLOG_H
@@ -0,0 +1,329 @@
+/********************************************
+ * frameAllocator - Frames per process
+ * The allocation strategies and the spec
+ * parser.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * frameAllocator .cpp file for project
+ ********************************************/
+
+#include <stdlib.h>
+#include <sstream>
+#include <algorithm>
+#include "frameAllocator.h"
+
+using namespace std;
+
+static const char* allocationNames[ALLOCATE_COUNT] =
+    { "global", "equal", "prop", "ws", "pff" };
+
+const char* GetFrameAllocationName(int type)
+{
+    if(type < 0 || type >= ALLOCATE_COUNT)
+        return "unknown";
+    return allocationNames[type];
+}
+
+std::string GetFrameAllocationNames()
+{
+    return "global, equal, prop, ws[:tau=1000], pff[:low=50:high=200]\n"
+           "       - each takes :period=100 (ms) and :min=2 (frames)";
+}
+
+bool ParseFrameAllocation(std::string strSpec, FrameAllocationParams& params)
+{
+    params = FrameAllocationParams();
+    stringstream ss(strSpec);
+    string strPart;
+    getline(ss, strPart, ':');
+    params.type = -1;
+    for(int i = 0; i < ALLOCATE_COUNT; i++)
+        if(strPart == allocationNames[i])
+            params.type = i;
+    if(params.type < 0)
+        return false;
+
+    while(getline(ss, strPart, ':'))
+    {
+        size_t nEquals = strPart.find('=');
+        if(nEquals == string::npos)
+            return false;
+        string strName = strPart.substr(0, nEquals);
+        int nValue = atoi(strPart.substr(nEquals + 1).c_str());
+
+        if(strName == "period" && nValue > 0)
+            params.periodMS = nValue;
+        else if(strName == "tau" && nValue > 0)
+            params.tauMS = nValue;
+        else if(strName == "low" && nValue >= 0)
+            params.pffLow = nValue;
+        else if(strName == "high" && nValue > 0)
+            params.pffHigh = nValue;
+        else if(strName == "min" && nValue > 0)
+            params.minFrames = nValue;
+        else
+            return false;
+    }
+    return params.pffLow < params.pffHigh;
+}
+
+frameAllocator::frameAllocator(const FrameAllocationParams& params, PCB* pcbs, int nPcbs,
+    FrameTableEntry* frames, int nFrames)
+    : _params(params), _pcbs(pcbs), _nPcbs(nPcbs), _frames(frames), _nFrames(nFrames),
+      _active(nPcbs), _quota(nPcbs, 0), _resident(nPcbs, 0), _faults(nPcbs, 0), _references(nPcbs, 0),
+      _tlbHitsSeen(nPcbs, 0), _touched(nPcbs, bitmapper(pageCount)), _nTouched(nPcbs, 0),
+      _nNextUpdate(0), _nUpdates(0), _nShifted(0)
+{
+    _params.minFrames = max(1, min(_params.minFrames, nFrames / max(1, nPcbs)));
+}
+
+void frameAllocator::onStart(int nPcb)
+{
+    _active.set(nPcb);
+    _faults[nPcb] = 0;
+    _references[nPcb] = 0;
+    _tlbHitsSeen[nPcb] = _pcbs[nPcb].tlbHits;
+    _touched[nPcb].clearRange(0, pageCount);
+    _nTouched[nPcb] = 0;
+
+    if(_params.type == ALLOCATE_PFF)
+    {
+        // Starts with an equal share, taken from the biggest
+        // quotas if the free ones don't cover it
+        setQuota(nPcb, min(max(_params.minFrames, _nFrames / _active.count()), pageCount));
+        trimQuotas(nPcb);
+    }
+    else if(isEnabled())
+    {
+        // Nothing is known about it yet - it starts small and the
+        // next update sizes it
+        setQuota(nPcb, _params.minFrames);
+        reshare();
+    }
+}
+
+void frameAllocator::onExit(int nPcb)
+{
+    _active.reset(nPcb);
+    setQuota(nPcb, 0);
+
+    // Its frames go back to the others.  Under pff they wait in
+    // the pool for whoever faults too often
+    if(isEnabled() && _params.type != ALLOCATE_PFF)
+        reshare();
+}
+
+// reshare - share the frames out again when a process comes or
+// goes, by the same measure the last update used
+void frameAllocator::reshare()
+{
+    vector<int> weights(_nPcbs, 0);
+    for(int i = _active.findFirstSet(); i >= 0; i = _active.findFirstSet(i + 1))
+    {
+        if(_params.type == ALLOCATE_EQUAL)
+            weights[i] = 1;
+        else if(_params.type == ALLOCATE_PROPORTIONAL)
+            weights[i] = _nTouched[i];
+        else
+            weights[i] = _quota[i];
+    }
+    shareOut(weights);
+}
+
+void frameAllocator::onFault(int nPcb, int nPage)
+{
+    _faults[nPcb]++;
+    if(!_touched[nPcb].test(nPage))
+    {
+        _touched[nPcb].set(nPage);
+        _nTouched[nPcb]++;
+    }
+}
+
+void frameAllocator::update(uint64_t now)
+{
+    if(_params.type == ALLOCATE_GLOBAL || _params.type == ALLOCATE_EQUAL || now < _nNextUpdate)
+        return;
+    _nNextUpdate = now + (uint64_t)_params.periodMS * 1000000;
+    _nUpdates++;
+
+    vector<int> weights(_nPcbs, 0);
+    if(_params.type == ALLOCATE_PROPORTIONAL)
+    {
+        // Sized by how much of its address space it has used
+        for(int i = _active.findFirstSet(); i >= 0; i = _active.findFirstSet(i + 1))
+            weights[i] = _nTouched[i];
+        shareOut(weights);
+    }
+    else if(_params.type == ALLOCATE_WORKINGSET)
+    {
+        // The working set is the resident pages used within tau,
+        // or hit in the TLB since the pager last looked, plus the
+        // pages it had to fault in since the last update
+        const uint64_t nTau = (uint64_t)_params.tauMS * 1000000;
+        for(int i = 0; i < _nFrames; i++)
+        {
+            const FrameTableEntry& fte = _frames[i];
+            if(fte.pcb > -1 && (fte.lastReference + nTau >= now
+                || _pcbs[fte.pcb].ptable[fte.page].isReferenced()))
+                weights[fte.pcb]++;
+        }
+        for(int i = _active.findFirstSet(); i >= 0; i = _active.findFirstSet(i + 1))
+            weights[i] = min(weights[i] + (int)_faults[i], pageCount);
+        shareOut(weights);
+    }
+    else
+        updatePff();
+
+    for(int i = 0; i < _nPcbs; i++)
+    {
+        _faults[i] = 0;
+        _references[i] = 0;
+        _tlbHitsSeen[i] = _pcbs[i].tlbHits;
+    }
+}
+
+// updatePff - processes faulting less than the low threshold give
+// up a quarter of their frames, then those faulting more than the
+// high threshold get up to a quarter more from what is free
+void frameAllocator::updatePff()
+{
+    vector<int> rates(_nPcbs, -1);
+    for(int i = _active.findFirstSet(); i >= 0; i = _active.findFirstSet(i + 1))
+    {
+        long nReferences = _references[i] + (long)(_pcbs[i].tlbHits - _tlbHitsSeen[i]);
+        if(nReferences > 0)
+            rates[i] = (int)(_faults[i] * 1000 / nReferences);
+    }
+
+    int nAllotted = 0;
+    for(int i = _active.findFirstSet(); i >= 0; i = _active.findFirstSet(i + 1))
+    {
+        if(rates[i] > -1 && rates[i] < _params.pffLow)
+            setQuota(i, max(_params.minFrames, _quota[i] - max(1, _quota[i] / 4)));
+        nAllotted += _quota[i];
+    }
+    for(int i = _active.findFirstSet(); i >= 0; i = _active.findFirstSet(i + 1))
+    {
+        if(rates[i] <= _params.pffHigh)
+            continue;
+        int nGrant = min(max(1, _quota[i] / 4), _nFrames - nAllotted);
+        nGrant = min(nGrant, pageCount - _quota[i]);
+        if(nGrant <= 0)
+            continue;
+        setQuota(i, _quota[i] + nGrant);
+        nAllotted += nGrant;
+    }
+}
+
+// shareOut - divide the frames between the running processes in
+// proportion to weights.  Every process gets at least minFrames and
+// nobody more than it has pages
+void frameAllocator::shareOut(const std::vector<int>& weights)
+{
+    long nTotal = 0;
+    for(int i = _active.findFirstSet(); i >= 0; i = _active.findFirstSet(i + 1))
+        nTotal += max(1, weights[i]);
+    if(nTotal == 0)
+        return;
+
+    int nAllotted = 0;
+    for(int i = _active.findFirstSet(); i >= 0; i = _active.findFirstSet(i + 1))
+    {
+        int nQuota = (int)((long)_nFrames * max(1, weights[i]) / nTotal);
+        setQuota(i, min(max(nQuota, _params.minFrames), pageCount));
+        nAllotted += _quota[i];
+    }
+
+    // Hand out what rounding left over, a frame at a time
+    bool bGiven = true;
+    while(nAllotted < _nFrames && bGiven)
+    {
+        bGiven = false;
+        for(int i = _active.findFirstSet(); i >= 0 && nAllotted < _nFrames;
+            i = _active.findFirstSet(i + 1))
+        {
+            if(_quota[i] >= pageCount)
+                continue;
+            setQuota(i, _quota[i] + 1);
+            nAllotted++;
+            bGiven = true;
+        }
+    }
+    trimQuotas(-1);
+}
+
+// trimQuotas - cut the quotas, other than keep's, until they all
+// fit in memory.  Each gives up frames in proportion to what it
+// has above minFrames
+void frameAllocator::trimQuotas(int nKeep)
+{
+    long nAllotted = 0, nSpare = 0;
+    for(int i = _active.findFirstSet(); i >= 0; i = _active.findFirstSet(i + 1))
+    {
+        nAllotted += _quota[i];
+        if(i != nKeep)
+            nSpare += max(0, _quota[i] - _params.minFrames);
+    }
+    const long nExcess = min(nAllotted - _nFrames, nSpare);
+    if(nExcess <= 0)
+        return;
+
+    long nLeft = nExcess;
+    for(int i = _active.findFirstSet(); i >= 0; i = _active.findFirstSet(i + 1))
+    {
+        if(i == nKeep || _quota[i] <= _params.minFrames)
+            continue;
+        int nCut = (int)((_quota[i] - _params.minFrames) * nExcess / nSpare);
+        setQuota(i, _quota[i] - nCut);
+        nLeft -= nCut;
+    }
+    // Rounding down leaves fewer frames over than there are quotas
+    // that gave some up, and each of those can spare one more
+    for(int i = _active.findFirstSet(); i >= 0 && nLeft > 0; i = _active.findFirstSet(i + 1))
+    {
+        if(i == nKeep || _quota[i] <= _params.minFrames)
+            continue;
+        setQuota(i, _quota[i] - 1);
+        nLeft--;
+    }
+}
+
+// setQuota - every quota change goes through here so the donors
+// stay ordered by how far over their quotas they are
+void frameAllocator::setQuota(int nPcb, int nQuota)
+{
+    unlistDonor(nPcb);
+    _quota[nPcb] = nQuota;
+    listDonor(nPcb);
+}
+
+void frameAllocator::setResident(int nPcb, int nResident)
+{
+    unlistDonor(nPcb);
+    _resident[nPcb] = nResident;
+    listDonor(nPcb);
+}
+
+void frameAllocator::unlistDonor(int nPcb)
+{
+    const int nOver = _resident[nPcb] - _quota[nPcb];
+    if(nOver > 0)
+        _donors.erase(make_pair(-nOver, nPcb));
+}
+
+void frameAllocator::listDonor(int nPcb)
+{
+    const int nOver = _resident[nPcb] - _quota[nPcb];
+    if(nOver > 0)
+        _donors.insert(make_pair(-nOver, nPcb));
+}
+
+int frameAllocator::findDonor()
+{
+    if(_donors.empty())
+        return -1;
+    _nShifted++;
+    return _donors.begin()->second;
+}
@@ -0,0 +1,126 @@
+/********************************************
+ * frameAllocator - Frames per process
+ * Decides how many frames each running process
+ * may hold.  global leaves every frame open to
+ * the replacement policy, as before.  The other
+ * strategies give each process a quota: equal
+ * shares, shares proportional to the pages it
+ * has touched, its working set over the last
+ * tau, or page fault frequency - more frames
+ * while it faults too often, fewer while it
+ * hardly faults.  A process at its quota
+ * replaces its own pages.  One under it takes
+ * a free frame, or else one from the process
+ * furthest over its quota, so frames move
+ * over to where the faults are.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * frameAllocator .h file for project
+ ********************************************/
+#ifndef FRAMEALLOCATOR_H
+#define FRAMEALLOCATOR_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <stdint.h>
+#include "pageTable.h"
+#include "frameTable.h"
+#include "bitmapper.h"
+
+enum FrameAllocation {
+    ALLOCATE_GLOBAL,        // No quotas - the policy picks from every frame
+    ALLOCATE_EQUAL,         // The same share for every process
+    ALLOCATE_PROPORTIONAL,  // Shares by pages touched so far
+    ALLOCATE_WORKINGSET,    // Shares by pages used within tau
+    ALLOCATE_PFF,           // Page fault frequency between two thresholds
+    ALLOCATE_COUNT
+};
+
+// A strategy and its settings
+struct FrameAllocationParams {
+    int type = ALLOCATE_GLOBAL;
+    int periodMS = 100;     // Sim ms between quota updates
+    int tauMS = 1000;       // ws - a page used within tau is in the working set
+    int pffLow = 50;        // pff - faults per 1000 references below which frames are given up
+    int pffHigh = 200;      // pff - faults per 1000 references above which more are given
+    int minFrames = 2;      // Fewest frames a process is cut back to
+};
+
+// Parses name[:key=value...], e.g. ws:tau=20 or pff:low=10:high=80.
+// Returns false if it is not valid
+bool ParseFrameAllocation(std::string, FrameAllocationParams&);
+
+// Name of a strategy
+const char* GetFrameAllocationName(int);
+
+// Names and settings, for usage messages
+std::string GetFrameAllocationNames();
+
+class frameAllocator
+{
+    private:
+        FrameAllocationParams _params;
+        PCB* _pcbs;
+        int _nPcbs;
+        FrameTableEntry* _frames;
+        int _nFrames;
+        bitmapper _active;                  // PCB slots with a process running
+        std::vector<int> _quota;
+        std::vector<int> _resident;         // Frames each PCB holds, as the pager counts them
+        std::set<std::pair<int, int> > _donors;  // Minus the surplus and PCB of those over quota
+        std::vector<long> _faults;          // Since the last update
+        std::vector<long> _references;      // Since the last update, TLB hits aside
+        std::vector<uint64_t> _tlbHitsSeen; // TLB hits already counted
+        std::vector<bitmapper> _touched;    // Pages each process has faulted on
+        std::vector<int> _nTouched;
+        uint64_t _nNextUpdate;
+        long _nUpdates;
+        long _nShifted;
+
+        void setQuota(int pcb, int quota);
+        void unlistDonor(int pcb);
+        void listDonor(int pcb);
+        void reshare();
+        void shareOut(const std::vector<int>& weights);
+        void trimQuotas(int keep);
+        void updatePff();
+
+    public:
+
+    frameAllocator(const FrameAllocationParams&, PCB* pcbs, int nPcbs,
+        FrameTableEntry* frames, int nFrames);
+
+    // A process starts or exits in a PCB slot
+    void onStart(int pcb);
+    void onExit(int pcb);
+
+    // A reference oss resolved, and a page fault
+    void onReference(int pcb) { _references[pcb]++; }
+    void onFault(int pcb, int page);
+
+    // Recompute the quotas if a period has gone by
+    void update(uint64_t now);
+
+    // Should pcb, holding resident frames, replace one of its own
+    bool atQuota(int pcb, int resident)
+    {
+        return resident > 0 && resident >= _quota[pcb];
+    }
+
+    // The pager's count of the frames pcb holds has changed
+    void setResident(int pcb, int resident);
+
+    // The process furthest over its quota - it gives up a frame.
+    // -1 if none are over
+    int findDonor();
+
+    bool isEnabled() { return _params.type != ALLOCATE_GLOBAL; }
+    const char* getName() { return GetFrameAllocationName(_params.type); }
+    int getQuota(int pcb) { return _quota[pcb]; }
+    long getUpdates() { return _nUpdates; }
+    long getShifted() { return _nShifted; }
+};
+
+#endif // FRAMEALLOCATOR_H
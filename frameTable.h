@@ -0,0 +1,32 @@
+/********************************************
+ * frameTable - Physical frame table entry
+ * The system-wide frame table lives in the
+ * oss shared memory.  This is kept apart from
+ * sharedStructures.h so the page replacement
+ * policies can be built on their own.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * frameTable .h file for project
+ ********************************************/
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+// One entry per physical frame.  Only oss writes it.  A TLB hit in
+// user_proc just sets the reference bit in the page table, the way an
+// MMU would, and the pager folds those bits in here before anything
+// that looks at the reference state
+struct FrameTableEntry {
+    int pcb;                // owning PCB index (-1 if free)
+    int page;               // page of the owning process held in this frame
+    uint dirty;             // must be written back before the frame is reused
+    uint reference;         // reference bit - cleared by the replacement policy
+    uint referenceCount;    // accesses since the page was loaded
+    uint64_t lastReference; // sim time of the last access
+    uint prefetched;        // read ahead and not accessed yet
+};
+
+#endif // FRAMETABLE_H
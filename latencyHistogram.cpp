@@ -0,0 +1,94 @@
+/********************************************
+ * latencyHistogram - Log bucketed latency histogram
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * latencyHistogram .cpp file for project
+ ********************************************/
+
+#include <string.h>
+#include "latencyHistogram.h"
+
+void latencyHistogram::clear()
+{
+    memset(_counts, 0, sizeof(_counts));
+    _nCount = 0;
+    _nSum = 0;
+    _nMin = UINT64_MAX;
+    _nMax = 0;
+}
+
+// Small values index directly.  Larger ones keep their top
+// histogramSubBits + 1 bits - the bucket is picked by how far
+// they had to be shifted to get there
+int latencyHistogram::getIndex(uint64_t value)
+{
+    if(value < (uint64_t)histogramLinearCount)
+        return (int)value;
+    int nShift = 63 - __builtin_clzll(value) - histogramSubBits;
+    return histogramLinearCount + (nShift - 1) * histogramSubCount
+        + (int)(value >> nShift) - histogramSubCount;
+}
+
+uint64_t latencyHistogram::getHighestInBucket(int nIndex)
+{
+    if(nIndex < histogramLinearCount)
+        return nIndex;
+    int nShift = (nIndex - histogramLinearCount) / histogramSubCount + 1;
+    uint64_t nSub = (nIndex - histogramLinearCount) % histogramSubCount + histogramSubCount;
+    return ((nSub + 1) << nShift) - 1;
+}
+
+void latencyHistogram::record(uint64_t value)
+{
+    record(value, 1);
+}
+
+void latencyHistogram::record(uint64_t value, uint64_t nTimes)
+{
+    if(nTimes == 0)
+        return;
+    _counts[getIndex(value)] += nTimes;
+    _nCount += nTimes;
+    _nSum += value * nTimes;
+    if(value < _nMin)
+        _nMin = value;
+    if(value > _nMax)
+        _nMax = value;
+}
+
+void latencyHistogram::merge(const latencyHistogram& other)
+{
+    for(int i = 0; i < histogramBucketCount; i++)
+        _counts[i] += other._counts[i];
+    _nCount += other._nCount;
+    _nSum += other._nSum;
+    if(other._nMin < _nMin)
+        _nMin = other._nMin;
+    if(other._nMax > _nMax)
+        _nMax = other._nMax;
+}
+
+uint64_t latencyHistogram::getPercentile(double fPercent) const
+{
+    if(_nCount == 0)
+        return 0;
+    uint64_t nTarget = (uint64_t)(fPercent / 100.0 * (double)_nCount + 0.5);
+    if(nTarget < 1)
+        nTarget = 1;
+    if(nTarget >= _nCount)
+        return _nMax;
+
+    uint64_t nSeen = 0;
+    for(int i = 0; i < histogramBucketCount; i++)
+    {
+        nSeen += _counts[i];
+        if(nSeen >= nTarget)
+        {
+            // Never report more than was actually seen
+            uint64_t nValue = getHighestInBucket(i);
+            return nValue < _nMax ? nValue : _nMax;
+        }
+    }
+    return _nMax;
+}
@@ -0,0 +1,67 @@
+/********************************************
+ * latencyHistogram - Log bucketed latency histogram
+ * Records latencies in buckets that double in
+ * width every power of 2, with 64 sub buckets
+ * each, so any value is held to within about
+ * 1.5% in a fixed 30KB.  Histograms from
+ * different threads or runs can be merged and
+ * percentiles read from the result.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * latencyHistogram .h file for project
+ ********************************************/
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Values below histogramLinearCount each get their own bucket.
+// Above that, every power of 2 is split into histogramSubCount
+const int histogramSubBits = 6;
+const int histogramSubCount = 1 << histogramSubBits;
+const int histogramLinearCount = 2 * histogramSubCount;
+const int histogramBucketCount = histogramLinearCount
+    + (64 - histogramSubBits - 1) * histogramSubCount;
+
+class latencyHistogram
+{
+    private:
+        uint64_t _counts[histogramBucketCount];
+        uint64_t _nCount;
+        uint64_t _nSum;
+        uint64_t _nMin;
+        uint64_t _nMax;
+
+        static int getIndex(uint64_t);
+        static uint64_t getHighestInBucket(int);
+
+    public:
+
+    latencyHistogram() { clear(); }
+
+    void clear();
+    void record(uint64_t value);
+    void record(uint64_t value, uint64_t nTimes);
+    void merge(const latencyHistogram&);
+
+    uint64_t getCount() const { return _nCount; }
+    uint64_t getMin() const { return _nCount ? _nMin : 0; }
+    uint64_t getMax() const { return _nMax; }
+    double getMean() const { return _nCount ? (double)_nSum / (double)_nCount : 0.0; }
+
+    // Smallest value at least fPercent of the values are at or
+    // below, to the precision of its bucket.  100 gives the max
+    uint64_t getPercentile(double fPercent) const;
+};
+
+// Returns a monotonic timestamp in nanoseconds
+inline uint64_t GetWallTimeNS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,167 @@
+/********************************************
+ * logWriter - Asynchronous log writer
+ * The background thread in oss that drains
+ * every process' log ring and writes the lines
+ * out through one long-lived file descriptor.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * logWriter .cpp file for project
+ ********************************************/
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include "logWriter.h"
+
+using namespace std;
+
+// Output is written out once this much is waiting, even if the
+// flush interval hasn't passed
+const size_t logFlushSize = 65536;
+
+// Returns a monotonic timestamp in milliseconds
+static long GetLogTimeMS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+// Writes all of a buffer, riding out short writes
+static void WriteAll(int fd, const char* data, size_t length)
+{
+    while(length > 0)
+    {
+        ssize_t n = write(fd, data, length);
+        if(n == -1 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return;
+        data += n;
+        length -= n;
+    }
+}
+
+logWriter::logWriter() : _logArea(NULL), _fd(-1), _nFlushIntervalMS(100), _stop(false),
+    _nLinesWritten(0), _nLinesDropped(0)
+{
+}
+
+logWriter::~logWriter()
+{
+    stop();
+}
+
+bool logWriter::start(LogArea* logArea, string strLogFile, int nFlushIntervalMS)
+{
+    _fd = open(strLogFile.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(_fd == -1)
+        return false;
+    _logArea = logArea;
+    _nFlushIntervalMS = max(1, nFlushIntervalMS);
+    _stop = false;
+    _output.reserve(2 * logFlushSize);
+    _partial.assign(logArea->channelCount, string());
+    _thread = thread(&logWriter::run, this);
+    return true;
+}
+
+void logWriter::stop()
+{
+    if(_fd == -1)
+        return;
+    _stop = true;
+    _logArea->doorbell++;
+    futexWake(&_logArea->doorbell);
+    _thread.join();
+    close(_fd);
+    _fd = -1;
+    // The log area may go away once we are stopped
+    _nLinesDropped = getLinesDropped();
+    _logArea = NULL;
+}
+
+long logWriter::getLinesDropped()
+{
+    if(_fd == -1)
+        return _nLinesDropped;
+    long nDropped = 0;
+    for(int i = 0; i < _logArea->channelCount; i++)
+        nDropped += _logArea->channel[i].dropped;
+    return nDropped;
+}
+
+void logWriter::run()
+{
+    long nLastFlush = GetLogTimeMS();
+    while(!_stop)
+    {
+        bool bDrained = drain();
+        long nNow = GetLogTimeMS();
+        if(_output.size() >= logFlushSize || nNow - nLastFlush >= _nFlushIntervalMS)
+        {
+            flush();
+            nLastFlush = nNow;
+        }
+        if(bDrained)
+            continue;
+
+        // Nothing new - sleep until the next flush is due or a
+        // process rings because its ring is filling up.  Announce
+        // the sleep, then check again so a ring can't be missed
+        unsigned int nDoorbell = _logArea->doorbell.load();
+        _logArea->writerSleeping = 1;
+        if(!drain() && !_stop)
+        {
+            long nWait = _output.empty() ? _nFlushIntervalMS
+                : max(1L, _nFlushIntervalMS - (GetLogTimeMS() - nLastFlush));
+            struct timespec timeout = { nWait / 1000, (nWait % 1000) * 1000000L };
+            futexWait(&_logArea->doorbell, nDoorbell, &timeout);
+        }
+        _logArea->writerSleeping = 0;
+    }
+
+    // Everything still in the rings goes out before we stop
+    drain();
+    flush();
+}
+
+// Moves every complete line waiting in the rings to the output.
+// Returns true if anything was taken
+bool logWriter::drain()
+{
+    bool bDrained = false;
+    LogChunk chunk;
+    for(int i = 0; i < _logArea->channelCount; i++)
+    {
+        while(_logArea->channel[i].ring.pop(chunk))
+        {
+            bDrained = true;
+            // A line left unfinished by a killed process is thrown away
+            if(chunk.startOfLine && !_partial[i].empty())
+            {
+                _partial[i].clear();
+                _logArea->channel[i].dropped++;
+            }
+            _partial[i].append(chunk.text, chunk.length);
+            if(chunk.endOfLine)
+            {
+                _output.append(_partial[i]);
+                _partial[i].clear();
+                _nLinesWritten++;
+            }
+        }
+    }
+    return bDrained;
+}
+
+void logWriter::flush()
+{
+    if(_output.empty())
+        return;
+    WriteAll(_fd, _output.data(), _output.size());
+    WriteAll(STDOUT_FILENO, _output.data(), _output.size());
+    _output.clear();
+}
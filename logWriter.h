@@ -0,0 +1,53 @@
+/********************************************
+ * logWriter - Asynchronous log writer
+ * The background thread in oss that drains
+ * every process' log ring and writes the lines
+ * out through one long-lived file descriptor.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * logWriter .h file for project
+ ********************************************/
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "asyncLog.h"
+
+class logWriter
+{
+    private:
+        LogArea* _logArea;
+        int _fd;
+        int _nFlushIntervalMS;
+        std::thread _thread;
+        std::atomic<bool> _stop;
+        std::string _output;                            // Whole lines waiting to be written
+        std::vector<std::string> _partial;              // Lines still being received
+        long _nLinesWritten;
+        long _nLinesDropped;                            // Counted when stopped
+
+        void run();
+        bool drain();
+        void flush();
+
+    public:
+
+    logWriter();
+    ~logWriter();
+
+    // Opens the log file and starts the writer thread
+    bool start(LogArea* logArea, std::string strLogFile, int nFlushIntervalMS);
+    // Writes out everything left and stops the thread
+    void stop();
+
+    bool isRunning() { return _fd != -1; }
+    long getLinesWritten() { return _nLinesWritten; }
+    // Lines processes dropped because their ring stayed full
+    long getLinesDropped();
+};
+
+#endif // LOGWRITER_H
@@ -14,40 +14,83 @@
 #include <string.h>
 #include <queue>
 #include <list>
+#include <unordered_map>
 #include <algorithm>
 #include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
 #include "productSemaphores.h"
 #include "sharedStructures.h"
 #include "bitmapper.h"
+#include "pageReplacement.h"
+#include "pager.h"
+#include "pagingDevice.h"
+#include "prefetcher.h"
+#include "pageCleaner.h"
+#include "frameAllocator.h"
+#include "traceFile.h"
+#include "logWriter.h"
+#include "eventLog.h"
+#include "latencyHistogram.h"
 #include "oss.h"
 
 using namespace std;
 
+// A whole read-ahead window has to fit in one stripe run
+static_assert(deviceStripeBlocks >= prefetchWindowMax, "read-ahead window is longer than a stripe run");
 
-// SIGINT handling
+
+// SIGINT handling - SIGINT is blocked and read from a signalfd
+// so it wakes the main loop like any other event
 volatile sig_atomic_t sigIntFlag = 0;
-void sigintHandler(int sig){ // can be called asynchronously
-  sigIntFlag = 1; // set flag
-}
+static sigset_t origSigMask;    // Restored in children before exec
+
+// What woke the main loop - child pidfds are tagged with
+// EVENT_CHILD + their PCB index
+enum OssEvents { EVENT_SIGNAL, EVENT_REQUEST, EVENT_CHILD };
+const int maxEpollEvents = 16;
+// Wall time to wait after a child could not be started
+const int forkRetryMS = 100;
+
+// Largest memory the end of run frame map is logged for
+const int memoryMapFramesMax = 4096;
+
+// How a memory access turned out, for the latency histograms
+enum LatencyOutcome { LATENCY_TLB_HIT, LATENCY_PAGE_HIT, LATENCY_CLEAN_FAULT,
+    LATENCY_DIRTY_FAULT, LATENCY_SEGFAULT, LATENCY_OUTCOME_COUNT };
+const char* latencyOutcomeNames[LATENCY_OUTCOME_COUNT] = {
+    "TLB hit", "Page hit", "Clean fault", "Dirty fault", "Seg fault" };
 
 // Forward Declarations
 int forkProcess(string, string, int);
-string GenerateMemLayout(const int, const PCB&);
+string FormatLatency(const latencyHistogram&, double, const char*);
+string GenerateMemLayout(const int, const PCB&, const FrameTableEntry*);
 
 // ossProcess - Process to start oss process.
-int ossProcess(string strLogFile, int nProcessesRequested)
+int ossProcess(string strLogFile, int nProcessesRequested, const OssOptions& options)
 {
-    // Make sure there are always no more than 20 processes
-    nProcessesRequested = min(nProcessesRequested, PROCESSES_MAX);
+    // A PCB slot for every process asked for - oss_main has
+    // already checked the count
+    SetProcessCount(nProcessesRequested);
+    // Processes started before oss shuts down - 40 at the default
+    // 20, and each slot gets at least one new process
+    const int nTotalProcessesMax = max(40, 2 * nProcessesRequested);
 
     // Important items
     struct OssHeader* ossHeader;
 
     int wstatus;
     long nNextTargetStartTime = 0;   // Next process' target start time
+    uint64_t nForkRetryNS = 0;      // No process is started before this wall time
+    struct epoll_event events[maxEpollEvents];
 
-    // Queues for managing processes
-    queue<MemQueueItems> IOQueue;
+    // Page faults wait on the paging devices
+    pagingDevices devices(options.nPagingDevices, options.strIOScheduler);
+    // Reply held for each process while its page fault is served
+    vector<message> faultReply(nProcessesRequested);
 
     // Pid used throughout child
     const pid_t nPid = getpid();
@@ -55,6 +98,9 @@ int ossProcess(string strLogFile, int nProcessesRequested)
     // Seed the randomizer with the PID
     srand(time(0) ^ nPid);
 
+    // Only log what was asked for
+    logLevel = options.nLogLevel;
+
     // Start Time for time Analysis
     // Get the time in seconds for our process to make
     // sure we don't exceed the max amount of processing time
@@ -65,30 +111,70 @@ int ossProcess(string strLogFile, int nProcessesRequested)
     replace(strLogFile.begin(), strLogFile.end(), '?', '_');
 
     // Print out the header
-    LogItem("------------------------------------------------\n", strLogFile);
-    LogItem("OSS by Brett Huffman - CMP SCI 4760 - Project 6\n", strLogFile);
-    LogItem("------------------------------------------------\n", strLogFile);
+    LOG_AT(LOGLEVEL_INFO, "------------------------------------------------\n", strLogFile);
+    LOG_AT(LOGLEVEL_INFO, "OSS by Brett Huffman - CMP SCI 4760 - Project 6\n", strLogFile);
+    LOG_AT(LOGLEVEL_INFO, "------------------------------------------------\n", strLogFile);
    
 
-    // Bitmap object for keeping track of children
+    // Bitmap object for keeping track of children, and the
+    // PCB slot each running child's pid is in
     bitmapper bm(nProcessesRequested);
-    bitmapper memory(totalMemory);
+    unordered_map<pid_t, int> pidToIndex;
+    pidToIndex.reserve(nProcessesRequested);
 
-    // Register SIGINT handling
-    signal(SIGINT, sigintHandler);
     bool isKilled = false;
     bool isShutdown = false;
 
+    // The main loop sleeps on one epoll set.  It wakes for ctrl-c
+    // (signalfd), incoming requests (eventfd rung by user_proc) and
+    // child exits (one pidfd per child)
+    vector<int> pidFds(nProcessesRequested, -1);
+    // With thousands of processes the pidfds can run past the
+    // default limit on open files, so raise it as far as allowed
+    struct rlimit fileLimit;
+    const rlim_t nFilesWanted = (rlim_t)nProcessesRequested + 64;
+    if(getrlimit(RLIMIT_NOFILE, &fileLimit) == 0 && fileLimit.rlim_cur < nFilesWanted)
+    {
+        fileLimit.rlim_cur = min(fileLimit.rlim_max, nFilesWanted);
+        setrlimit(RLIMIT_NOFILE, &fileLimit);
+    }
+    sigset_t sigMask;
+    sigemptyset(&sigMask);
+    sigaddset(&sigMask, SIGINT);
+    sigprocmask(SIG_BLOCK, &sigMask, &origSigMask);
+    int sigFd = signalfd(-1, &sigMask, SFD_CLOEXEC);
+    // Not close-on-exec: user_proc inherits it to ring the doorbell
+    int requestFd = eventfd(0, EFD_NONBLOCK);
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if(sigFd == -1 || requestFd == -1 || epollFd == -1)
+    {
+        perror("OSS: Could not create event descriptors");
+        exit(EXIT_FAILURE);
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u32 = EVENT_SIGNAL;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, sigFd, &ev);
+    ev.data.u32 = EVENT_REQUEST;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, requestFd, &ev);
+
     // Statistics
-    int nProcessCount = 0;   // 100 MAX
+    int nProcessCount = 0;   // Running now - at most nProcessesRequested
     int nTotalProcessCount = 0;
-    int nTotalTime = 0;
-    int nLastIOProcessTime = 0;
-    int nNumberMemoryAccesses = 0;
-    int nNumberPageFaults = 0;
-    int nNumberSegFaults = 0;
-    int MemoryAccessesTotalTimeNS = 0;
-    int MemoryAccessesTotalTimeS = 0;
+    double fltTotalTime = 0.0;      // Sim seconds
+    long nNumberMemoryAccesses = 0;
+    long nNumberPageFaults = 0;
+    long nNumberSegFaults = 0;
+    long nTlbHits = 0;
+    long nTlbMisses = 0;
+
+    // Access latency by outcome, in sim time and wall time.  A fault
+    // is timed from its request to its reply
+    vector<latencyHistogram> simLatency(LATENCY_OUTCOME_COUNT);
+    vector<latencyHistogram> wallLatency(LATENCY_OUTCOME_COUNT);
+    vector<uint64_t> faultStartSim(nProcessesRequested);
+    vector<uint64_t> faultStartWall(nProcessesRequested);
+    vector<bool> faultDirty(nProcessesRequested);
 
     // Create a Semaphore to coordinate control
     productSemaphores s(KEY_MUTEX, true, 1);
@@ -108,8 +194,9 @@ int ossProcess(string strLogFile, int nProcessesRequested)
 
     // Setup shared memory
     // allocate a shared memory segment with size of 
-    // Product Header + entire Product array
-    int memSize = sizeof(struct OssHeader);
+    // Product Header + entire Product array.  The PCBs, page tables
+    // and frame table are sized by the memory geometry
+    size_t memSize = GetSegmentSize();
 
     shm_id = shmget(KEY_SHMEM, memSize, IPC_CREAT | IPC_EXCL | 0660);
     if (shm_id == -1) {
@@ -126,25 +213,89 @@ int ossProcess(string strLogFile, int nProcessesRequested)
 
     // Get the queue header
     ossHeader = (struct OssHeader*) (shm_addr);
+    LayoutSegment(ossHeader);
 
     // Fill the product header
-    ossHeader->simClockSeconds = 0;
-    ossHeader->simClockNanoseconds = 0;
+    ossHeader->simClockNS = 0;
+    ossHeader->transportMode = options.useMessageQueue ? TRANSPORT_MSGQUEUE : TRANSPORT_RING;
+    ossHeader->requestEventFd = requestFd;
+    ossHeader->requestsPending = 0;
+    ossHeader->ossSleeping = 0;
+    // A trace has to see every reference, so TLB hits are
+    // turned off while recording
+    ossHeader->tlbEnabled = options.strTraceRecordFile.empty();
+    ossHeader->batchSize = max(1, min(options.nBatchSize, maxBatchSize));
+    // The reference pattern - oss_main already checked the spec
+    ParseWorkload(options.strWorkload, ossHeader->workload);
+
+    // From here on log lines go through the log rings and the
+    // writer thread - no file opens under the semaphore
+    InitLogArea(&ossHeader->log);
+    logWriter logger;
+    if(logger.start(&ossHeader->log, strLogFile, options.nLogFlushMS))
+    {
+        logArea = &ossHeader->log;
+        logChannel = GetLogOssChannel(&ossHeader->log);
+    }
+    else
+        perror("OSS: Could not start the log writer - logging directly");
+
+    // The page replacement policy picked on the command line.
+    // oss_main has already checked the name.  The pager owns
+    // the frames and starts them all out free
+    pageReplacement* replacement = CreatePageReplacement(options.strReplacementPolicy,
+        ossHeader->frameTable.get(), totalMemory);
+    pager memoryPager(ossHeader->pcb.get(), processesMax, ossHeader->frameTable.get(),
+        totalMemory, replacement);
+    // Sequential and strided faults read ahead into free frames
+    prefetcher readAhead(processesMax, options.nPrefetchWindow);
+    memoryPager.setPrefetcher(&readAhead);
+    // TLB hits only reach us as PTE reference bits
+    memoryPager.setTlbReferences(ossHeader->tlbEnabled);
+    // How many frames each process may hold - global leaves it to
+    // the replacement policy.  oss_main has already checked the spec
+    FrameAllocationParams allocation;
+    ParseFrameAllocation(options.strFrameAllocation, allocation);
+    frameAllocator allocator(allocation, ossHeader->pcb.get(), processesMax,
+        ossHeader->frameTable.get(), totalMemory);
+    memoryPager.setAllocator(&allocator);
+    vector<int> prefetchPages;
+    // Dirty pages are written out in the background so evictions
+    // find clean victims
+    pageCleaner cleaner(totalMemory, options.nCleanerLowWater);
+
+    // Binary event log, if asked for - decode it with ossdump
+    eventLogWriter eventLog;
+    if(!options.strEventLogFile.empty() && !eventLog.open(options.strEventLogFile))
+    {
+        perror("OSS: Could not create event log");
+        exit(EXIT_FAILURE);
+    }
+
+    // Record every reference oss handles, if asked to
+    traceWriter trace;
+    if(!options.strTraceRecordFile.empty()
+        && !trace.open(options.strTraceRecordFile, pageSize, pageCount, processesMax))
+    {
+        perror("OSS: Could not create trace file");
+        exit(EXIT_FAILURE);
+    }
+
+    // user_proc picks up the log level from here
+    ossHeader->logLevel = logLevel;
 
     // Setup all the arrays
     // Setup all Descriptors per instructions
     for(int i=0; i < nProcessesRequested && !isShutdown; i++)
     {
         ossHeader->pcb[i].pid = -1;
-        ossHeader->pcb[i].currentFrame = 0;
-        for(int j=0; j < pageCount; j++)
-        {
-            ossHeader->pcb[i].ptable[j].frame = -1;
-            ossHeader->pcb[i].ptable[j].reference = 0;
-            ossHeader->pcb[i].ptable[j].protection = rand() % 2;
-            ossHeader->pcb[i].ptable[j].dirty = 0;
-            ossHeader->pcb[i].ptable[j].valid = 0;
-        }
+        ossHeader->pcb[i].tlbGeneration = 0;
+        ossHeader->pcb[i].tlbHits = 0;
+        ossHeader->pcb[i].tlbMisses = 0;
+        ossHeader->tlbHitLatency[i].clear();
+        ossHeader->channel[i].request.init();
+        ossHeader->channel[i].response.init();
+        memoryPager.resetProcess(i);
     }
 
     // For debugging
@@ -162,63 +313,77 @@ int ossProcess(string strLogFile, int nProcessesRequested)
     while(!isShutdown)
     {
         // Every loop gets 100-10000ns for processing time
-        s.Wait();
-        ossHeader->simClockNanoseconds += getRandomValue(10, 10000);
-        if(ossHeader->simClockNanoseconds > 1000000000)
-        {
-            ossHeader->simClockSeconds += floor(ossHeader->simClockNanoseconds/1000000000);
-            ossHeader->simClockNanoseconds -= 1000000000;
-        }
-        s.Signal();
-
-        if(MemoryAccessesTotalTimeNS > 1000000000)
-        {
-            MemoryAccessesTotalTimeS += floor(MemoryAccessesTotalTimeNS/1000000000);
-            MemoryAccessesTotalTimeNS -= 1000000000;
-        }
+        AdvanceSimClock(ossHeader, getRandomValue(10, 10000));
 
         // ********************************************
         // Create New Processes
         // ********************************************
         // Check bitmap for room to make new processes
-        if(nProcessCount < nProcessesRequested && !isKilled)
+        if(nProcessCount < nProcessesRequested && !isKilled && GetWallTimeNS() >= nForkRetryNS)
         {
-            // Check if there is room for new processes
-            // in the bitmap structure
-            int nIndex = 0;
-            for(;nIndex < nProcessesRequested; nIndex++)
+            // Take free PCB slots straight from the bitmap
+            // until every requested process is running
+            int nIndex;
+            while(nProcessCount < nProcessesRequested
+                && (nIndex = bm.findFirstClear()) >= 0)
             {
-                if(!bm.getBitmapBits(nIndex))
+                // Clear out anything the last process
+                // left in its rings, then create new process
+                while(ossHeader->channel[nIndex].request.pop(msg))
+                    ossHeader->requestsPending--;
+                ossHeader->channel[nIndex].request.init();
+                ossHeader->channel[nIndex].response.init();
+                int newPID = forkProcess(ChildProcess, strLogFile, nIndex);
+
+                // Watch for it to exit.  Its exit would go unseen
+                // without a pidfd, so then it is stopped again
+                int nPidFd = newPID > 0 ? syscall(SYS_pidfd_open, newPID, 0) : -1;
+                if(newPID > 0 && nPidFd == -1)
                 {
-                    // Found one.  Create new process
-                    int newPID = forkProcess(ChildProcess, strLogFile, nIndex);
-
-                    // Set bit in bitmap
-                    bm.setBitmapBits(nIndex, true);
-
-                    // Protected setup and Log it
-                    s.Wait();
-
-                    // Setup Shared Memory for processing
-                    ossHeader->pcb[nIndex].pid = newPID;
-
-                    LogItem("OSS  ", ossHeader->simClockSeconds,
-                        ossHeader->simClockNanoseconds, "Generating new process", 
-                        newPID,
-                        nIndex, strLogFile);
-
-                    // Log Process Status
-                    LogItem("Startup Process PCB Index " + GetStringFromInt(nIndex), strLogFile);
-                    LogItem(bm.getBitView(), strLogFile);
-                    
-                    // Every new process gets 1-500ms for scheduling time
-                    ossHeader->simClockNanoseconds += getRandomValue(1000, 500000);
-                    s.Signal();
-
-                    // Increment how many have been made
-                    nProcessCount++;
-                    nTotalProcessCount++;
+                    perror("OSS: Could not open pidfd");
+                    kill(newPID, SIGQUIT);
+                    waitpid(newPID, &wstatus, 0);
+                }
+                if(nPidFd == -1)
+                {
+                    // Out of processes or descriptors - the slot stays
+                    // free until the next try
+                    nForkRetryNS = GetWallTimeNS() + (uint64_t)forkRetryMS * 1000000;
+                    break;
                 }
+                pidFds[nIndex] = nPidFd;
+                ev.events = EPOLLIN;
+                ev.data.u32 = EVENT_CHILD + nIndex;
+                epoll_ctl(epollFd, EPOLL_CTL_ADD, pidFds[nIndex], &ev);
+
+                // Set bit in bitmap
+                bm.setBitmapBits(nIndex, true);
+
+                // Protected setup and Log it
+                s.Wait();
+
+                // Setup Shared Memory for processing
+                ossHeader->pcb[nIndex].pid = newPID;
+                pidToIndex[newPID] = nIndex;
+                allocator.onStart(nIndex);
+                eventLog.write(EVENT_PROCESS_START, OUTCOME_NONE, GetSimClock(ossHeader),
+                    newPID, nIndex, 0, -1);
+
+                LOG_AT(LOGLEVEL_INFO, "OSS  ", GetSimClock(ossHeader), "Generating new process", 
+                    newPID,
+                    nIndex, strLogFile);
+
+                // Log Process Status
+                LOG_AT(LOGLEVEL_VERBOSE, "Startup Process PCB Index " + GetStringFromInt(nIndex), strLogFile);
+                LOG_AT(LOGLEVEL_VERBOSE, bm.getBitView(), strLogFile);
+                
+                // Every new process gets 1-500ms for scheduling time
+                AdvanceSimClock(ossHeader, getRandomValue(1000, 500000));
+                s.Signal();
+
+                // Increment how many have been made
+                nProcessCount++;
+                nTotalProcessCount++;
             }
         }
 
@@ -228,45 +393,34 @@ int ossProcess(string strLogFile, int nProcessesRequested)
         // Terminate the process if CTRL-C is typed
         // or if the max time-to-process has been exceeded
         // but only send out messages to kill once
-        if((sigIntFlag || time(NULL) - secondsStart > 10 || nTotalProcessCount > 40) && isKilled==false)
+        if((sigIntFlag || time(NULL) - secondsStart > maxTimeToRunInSeconds || nTotalProcessCount > nTotalProcessesMax) && isKilled==false)
         {
             isKilled = true;
 
             // Send signal for every child process to terminate
-            for(int nIndex=0;nIndex<nProcessesRequested;nIndex++)
-            {
-                // Send signal to close if they are in-process
-                s.Wait();
+            s.Wait();
 
-                // Clear the wait queue
-                while(!IOQueue.empty())
+            // Clear the device queues
+            for(MemQueueItems& mqi : devices.clear())
+            {
+                if(mqi.address > -1 && mqi.pcb > -1)
                 {
-                    MemQueueItems mqi = IOQueue.front();
-                    IOQueue.pop();
-                    if(mqi.address > -1 && mqi.pcb > -1)
-                    {
-                        // Send memory response to waiting process
-                        msg.action = OK;
-                        msg.type = ossHeader->pcb[mqi.pcb].pid;
-                        msg.memoryAddress = 0;
-                        int n = msgsnd(msgid, (void *) &msg, sizeof(message), IPC_NOWAIT);
-                    }
+                    // Send memory response to waiting process
+                    msg.action = OK;
+                    msg.memoryAddress = 0;
+                    msg.batchCount = 0;
+                    SendToProcess(ossHeader, msgid, mqi.pcb, msg);
                 }
+            }
 
-
-                if(bm.getBitmapBits(nIndex))
-                {
-                    // Kill it and update our bitmap
-                    kill(ossHeader->pcb[nIndex].pid, SIGQUIT);
-                    bm.setBitmapBits(nIndex, false);
-
-                    // Send back the message to continue shutdown
-//                    msg.action = PROCESS_SHUTDOWN;
-//                    msg.type = ossHeader->pcb[nIndex].pid;
-//                    int n = msgsnd(msgid, (void *) &msg, sizeof(message), IPC_NOWAIT);
-                }
-                s.Signal();
+            // Only the slots in use are visited
+            for(int nIndex = bm.findFirstSet(); nIndex >= 0; nIndex = bm.findFirstSet(nIndex + 1))
+            {
+                // Kill it and update our bitmap
+                kill(ossHeader->pcb[nIndex].pid, SIGQUIT);
+                bm.setBitmapBits(nIndex, false);
             }
+            s.Signal();
             
             // We have notified children to terminate immediately
             // then let program shutdown naturally -- that way
@@ -281,237 +435,348 @@ int ossProcess(string strLogFile, int nProcessesRequested)
 
 
         // ********************************************
-        // Handle Child Shutdowns
+        // Wait for Events
         // ********************************************
-        // Check for a PID
-        // Note :: We use the WNOHANG to call waitpid without blocking
-        // If it returns 0, it does not have a PID waiting
-        int waitPID = waitpid(-1, &wstatus, WNOHANG | WUNTRACED | WCONTINUED);
-
-        // No PIDs are in-process
-        if (waitPID == -1)
+        // Sleep until a request arrives, a child exits or ctrl-c.
+        // Don't sleep if a request is already waiting or an I/O can
+        // be completed.  Until the kill, wake up for the time limit
+        int nTimeout = -1;
+        if(!isKilled)
+            nTimeout = max(0L, (long)(secondsStart + maxTimeToRunInSeconds + 1 - time(NULL)) * 1000);
+        // or for the next try at starting a process
+        if(!isKilled && nProcessCount < nProcessesRequested)
         {
-            isShutdown = true;
-            continue;
+            const uint64_t nNow = GetWallTimeNS();
+            long nRetry = nForkRetryNS > nNow ? (long)((nForkRetryNS - nNow) / 1000000) + 1 : 0;
+            nTimeout = min((long)nTimeout, nRetry);
         }
-
-        // A PID Exited
-        if (WIFEXITED(wstatus) && waitPID > 0)
+        if(!devices.isIdle())
+            nTimeout = 0;
+        // Announce we are going to sleep, then re-check so a request
+        // sent between the two still rings the doorbell
+        ossHeader->ossSleeping = 1;
+        if(ossHeader->requestsPending > 0)
+            nTimeout = 0;
+        int nEvents = epoll_wait(epollFd, events, maxEpollEvents, nTimeout);
+        ossHeader->ossSleeping = 0;
+
+        for(int nEvent = 0; nEvent < nEvents; nEvent++)
         {
-
-            // Find the PID and remove it from the bitmap
-            s.Wait();
-            for(int nIndex=0;nIndex<nProcessesRequested;nIndex++)
+            if(events[nEvent].data.u32 == EVENT_SIGNAL)
+            {
+                struct signalfd_siginfo siginfo;
+                if(read(sigFd, &siginfo, sizeof(siginfo)) > 0)
+                    sigIntFlag = 1;
+            }
+            else if(events[nEvent].data.u32 == EVENT_REQUEST)
+            {
+                // Just reset the doorbell - requests are drained below
+                uint64_t nCount;
+                read(requestFd, &nCount, sizeof(nCount));
+            }
+            else
             {
-                if(ossHeader->pcb[nIndex].pid == waitPID)
+                // ********************************************
+                // Handle Child Shutdowns
+                // ********************************************
+                // The child's pidfd is readable, so it has exited
+                int nIndex = events[nEvent].data.u32 - EVENT_CHILD;
+                pid_t waitPID = ossHeader->pcb[nIndex].pid;
+                waitpid(waitPID, &wstatus, 0);
+                pidToIndex.erase(waitPID);
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, pidFds[nIndex], NULL);
+                close(pidFds[nIndex]);
+
+                if (WIFSIGNALED(wstatus) && LogEnabled(LOGLEVEL_VERBOSE))
+                    cout << waitPID << " killed by signal " << WTERMSIG(wstatus) << endl;
+
+                // Clear out the PCB and return all Frames for this
+                // shutting down process to the frame table
+                s.Wait();
+                ossHeader->pcb[nIndex].pid = -1;
+                memoryPager.resetProcess(nIndex);
+                readAhead.resetProcess(nIndex);
+                allocator.onExit(nIndex);
+                eventLog.write(EVENT_PROCESS_EXIT, OUTCOME_NONE, GetSimClock(ossHeader),
+                    waitPID, nIndex, 0, -1);
+                if(trace.isOpen())
                 {
-                    // Clear out the PCB and all Frames for this
-                    // shutting down process
-                    ossHeader->pcb[nIndex].pid = -1;
-                    ossHeader->pcb[nIndex].currentFrame = 0;
-                    for(int j=0; j < pageCount; j++)
-                    {
-                        ossHeader->pcb[nIndex].ptable[j].frame = -1;
-                        ossHeader->pcb[nIndex].ptable[j].reference = 0;
-                        ossHeader->pcb[nIndex].ptable[j].protection = rand() % 2;
-                        ossHeader->pcb[nIndex].ptable[j].dirty = 0;
-                        ossHeader->pcb[nIndex].ptable[j].valid = 0;
-                    }
-
-                    // Reset to start over
-                    ossHeader->pcb[nIndex].pid = 0;
-                    bm.setBitmapBits(nIndex, false);
-                    nProcessCount--;
-
-                    LogItem("OSS  ", ossHeader->simClockSeconds,
-                        ossHeader->simClockNanoseconds, "Process signaled shutdown", 
-                        waitPID,
-                        nIndex, strLogFile);
-                    LogItem("Shutdown Process PCB Index " + GetStringFromInt(nIndex), strLogFile);
-                    LogItem(bm.getBitView(), strLogFile);
-
-                    break;
+                    TraceRecord rec = { nIndex, TRACE_EXIT, 0, GetSimClock(ossHeader) };
+                    trace.write(rec);
                 }
+
+                // Collect its TLB statistics
+                nTlbHits += ossHeader->pcb[nIndex].tlbHits;
+                nTlbMisses += ossHeader->pcb[nIndex].tlbMisses;
+                ossHeader->pcb[nIndex].tlbHits = 0;
+                ossHeader->pcb[nIndex].tlbMisses = 0;
+
+                // Reset to start over
+                ossHeader->pcb[nIndex].pid = 0;
+                bm.setBitmapBits(nIndex, false);
+                nProcessCount--;
+
+                LOG_AT(LOGLEVEL_INFO, "OSS  ", GetSimClock(ossHeader), "Process signaled shutdown", 
+                    waitPID,
+                    nIndex, strLogFile);
+                LOG_AT(LOGLEVEL_VERBOSE, "Shutdown Process PCB Index " + GetStringFromInt(nIndex), strLogFile);
+                LOG_AT(LOGLEVEL_VERBOSE, bm.getBitView(), strLogFile);
+                s.Signal();
             }
-            s.Signal();
+        }
 
-        } else if (WIFSIGNALED(wstatus) && waitPID > 0) {
-            cout << waitPID << " killed by signal " << WTERMSIG(wstatus) << endl;
-        } else if (WIFSTOPPED(wstatus) && waitPID > 0) {
-            cout << waitPID << " stopped by signal " << WTERMSIG(wstatus) << endl;
-        } else if (WIFCONTINUED(wstatus) && waitPID > 0) {
+        // Once killed, shutdown when every child is gone
+        if(isKilled && nProcessCount == 0)
+        {
+            isShutdown = true;
+            continue;
         }
 
         // ********************************************
         // Manage Child Requests
         // ********************************************
-        while(msgrcv(msgid, (void *) &msg, sizeof(message), OSS_MQ_TYPE, IPC_NOWAIT) > 0)
+        while(ReceiveFromAnyProcess(ossHeader, msgid, nProcessesRequested, msg))
         {
-            int nProcessID = msg.procPid;
+            // Look the sender up by pid.  A request left in the queue
+            // by a process that has since been reaped is dropped, so
+            // it can't be charged to whoever reused its slot
+            auto itSender = pidToIndex.find(msg.procPid);
+            if(itSender == pidToIndex.end())
+                continue;
+            msg.procIndex = itSender->second;
+
             /*
             s.Wait();
-            LogItem("OSS  ", ossHeader->simClockSeconds,
-                ossHeader->simClockNanoseconds, "Received Message from Process " + GetStringFromInt(msg.procIndex) + " : " + GetStringFromInt(msg.action), 
+            LogItem("OSS  ", GetSimClock(ossHeader), "Received Message from Process " + GetStringFromInt(msg.procIndex) + " : " + GetStringFromInt(msg.action), 
                 msg.procPid, msg.procIndex, strLogFile);
             s.Signal();
             */
             if(msg.action==PROCESS_SHUTDOWN)
             {
-                s.Wait();
-                LogItem("OSS  ", ossHeader->simClockSeconds,
-                    ossHeader->simClockNanoseconds, "Process Shutdown Message " + GetStringFromInt(msg.procIndex) + " : " + GetStringFromInt(msg.action), 
+                LOG_AT(LOGLEVEL_VERBOSE, "OSS  ", GetSimClock(ossHeader), "Process Shutdown Message " + GetStringFromInt(msg.procIndex) + " : " + GetStringFromInt(msg.action), 
                     msg.procPid, msg.procIndex, strLogFile);
-                s.Signal();
 
                 // Send back the message to continue shutdown
                 msg.action = OK;
-                msg.type = nProcessID;
-                int n = msgsnd(msgid, (void *) &msg, sizeof(message), 0); //IPC_NOWAIT);
+                SendToProcess(ossHeader, msgid, msg.procIndex, msg);
             }
-            else if(msg.action==FRAME_READ || msg.action==FRAME_WRITE)
+            else if(msg.action==FRAME_READ || msg.action==FRAME_WRITE || msg.action==FRAME_BATCH)
             {
-                nNumberMemoryAccesses++;
-
-                // Check if the memory address is out of range.  If so, throw and
-                // fault and shutdown that process
-                if(msg.memoryAddress < 0 || msg.memoryAddress > 32767)
-                {
-                    s.Wait();
-                    LogItem("OSS  ", ossHeader->simClockSeconds,
-                        ossHeader->simClockNanoseconds, "Memory request of range found: " + GetStringFromInt(msg.memoryAddress) + " shutting down process", 
-                        msg.procPid, msg.procIndex, strLogFile);
-                    s.Signal();
-
-                    nNumberSegFaults++;
-                    // Send back the message to shutdown process
-                    msg.action = PROCESS_SHUTDOWN;
-                    msg.type = nProcessID;
-                    int n = msgsnd(msgid, (void *) &msg, sizeof(message), 0); //IPC_NOWAIT);
-                }
-                else
+                // A single request is handled as a batch of one.  The
+                // references are resolved in order up to the first fault;
+                // the reply waits for that fault to be served
+                const bool isBatch = (msg.action==FRAME_BATCH);
+                const int nReferences = isBatch ? max(0, min(msg.batchCount, maxBatchSize)) : 1;
+                message reply = msg;
+                reply.action = OK;
+                reply.batchCount = 0;
+                bool bReplyQueued = false;
+
+                for(int nRef = 0; nRef < nReferences; nRef++)
                 {
+                    const uint address = isBatch ? msg.batchAddress[nRef] : msg.memoryAddress;
+                    const bool isWrite = isBatch ? (msg.batchWrite >> nRef) & 1 : msg.action==FRAME_WRITE;
+
+                    nNumberMemoryAccesses++;
+                    allocator.onReference(msg.procIndex);
+                    const uint64_t nStartSim = GetSimClock(ossHeader);
+                    const uint64_t nStartWall = GetWallTimeNS();
+                    if(trace.isOpen())
+                    {
+                        TraceRecord rec = { msg.procIndex, isWrite ? TRACE_WRITE : TRACE_READ,
+                            address, GetSimClock(ossHeader) };
+                        trace.write(rec);
+                    }
 
-                    // First, check if the frame is already in our page table
-                    int foundFrame = -1;
-                    for(int i = 0; i < pageCount; i++)
+                    // Translate the address. The page number indexes directly
+                    // into the requesting process' page table
+                    const int nPage = GetPageNumber(address);
+                    const int nOffset = GetPageOffset(address);
+                    int nFrame;
+                    PagerResult result = memoryPager.access(msg.procIndex, address,
+                        isWrite, GetSimClock(ossHeader), nFrame);
+                    eventLog.write(EVENT_ACCESS, result == PAGE_HIT ? OUTCOME_HIT
+                        : result == PAGE_FAULT ? OUTCOME_FAULT : OUTCOME_SEGFAULT,
+                        GetSimClock(ossHeader), msg.procPid, msg.procIndex, address,
+                        result == PAGE_HIT ? nFrame : -1);
+
+                    // Check if the memory address is out of range.  If so, throw and
+                    // fault and shutdown that process
+                    if(result == PAGE_SEGFAULT)
                     {
-                        // If we've found this memory in the ptable and it's valid...
-                        if(ossHeader->pcb->ptable[i].frame==msg.memoryAddress && ossHeader->pcb->ptable[i].valid)
-                        {
-                            foundFrame = i;
-                            if(msg.action==FRAME_WRITE)
-                                ossHeader->pcb->ptable[i].dirty = 1;
-                            break;
-                        }
+                        LOG_AT(LOGLEVEL_INFO, "OSS  ", GetSimClock(ossHeader), "Memory request of range found: " + GetStringFromInt(address) + " shutting down process", 
+                            msg.procPid, msg.procIndex, strLogFile);
+
+                        nNumberSegFaults++;
+                        simLatency[LATENCY_SEGFAULT].record(GetSimClock(ossHeader) - nStartSim);
+                        wallLatency[LATENCY_SEGFAULT].record(GetWallTimeNS() - nStartWall);
+                        // Send back the message to shutdown process
+                        reply.action = PROCESS_SHUTDOWN;
+                        break;
                     }
 
                     // Found the frame, grant it to the requesting client
-                    if(foundFrame > -1)
+                    if(result == PAGE_HIT)
                     {
-                        s.Wait();
                         // Add approx 14 ms for each read/write
-                        ossHeader->simClockNanoseconds += 14000000;
-                        MemoryAccessesTotalTimeNS += 14000000;
-                        LogItem("OSS  ", ossHeader->simClockSeconds,
-                            ossHeader->simClockNanoseconds, "Received Memory Request " + GetStringFromInt(msg.memoryAddress) + " Found",
+                        AdvanceSimClock(ossHeader, 14000000);
+                        simLatency[LATENCY_PAGE_HIT].record(GetSimClock(ossHeader) - nStartSim);
+                        wallLatency[LATENCY_PAGE_HIT].record(GetWallTimeNS() - nStartWall);
+                        LOG_AT(LOGLEVEL_TRACE, "OSS  ", GetSimClock(ossHeader), "Received Memory Request " + GetStringFromInt(address) + " Found in Frame " + GetStringFromInt(nFrame),
                             msg.procPid, msg.procIndex, strLogFile);
-                        s.Signal();
 
-                        // Memory aquired, continue
-                        msg.action = OK;
-                        msg.type = nProcessID;
-                        msg.memoryAddress = msg.memoryAddress;
-                        int n = msgsnd(msgid, (void *) &msg, sizeof(message), 0); //IPC_NOWAIT);
+                        // Memory aquired, continue - reply with the
+                        // physical address (frame + offset)
+                        reply.memoryAddress = GetPhysicalAddress(nFrame, nOffset);
+                        reply.batchAddress[reply.batchCount++] = reply.memoryAddress;
+                        continue;
                     }
-                    else
-                    {   // Not found. Interrupt and Queue for disk retrieval
-                        if(msg.procIndex > 0 && bm.getBitmapBits(msg.procIndex)
-                            && msg.memoryAddress > 0)
-                        {
-                            // Page fault!!
-                            nNumberPageFaults++;
-
-                            MemQueueItems mqi;
-                            mqi.pcb = msg.procIndex;
-                            mqi.address = msg.memoryAddress;
-                            IOQueue.push(mqi);
-                            s.Wait();
-                            // Add approx 14 ms for each read/write
-                            ossHeader->simClockNanoseconds += 14000000;
-                            MemoryAccessesTotalTimeNS += 14000000;
-                            LogItem("OSS  ", ossHeader->simClockSeconds,
-                                ossHeader->simClockNanoseconds, "Received Memory Request " + GetStringFromInt(msg.memoryAddress) + " Not Found\n\t Page Fault - Queued for Retreival", 
-                                msg.procPid, msg.procIndex, strLogFile);
-                            s.Signal();                
-                        }
+
+                    // Not found. Interrupt and Queue for disk retrieval
+                    if(msg.procIndex >= 0 && msg.procIndex < nProcessesRequested
+                        && bm.getBitmapBits(msg.procIndex))
+                    {
+                        // Page fault!!
+                        nNumberPageFaults++;
+                        allocator.onFault(msg.procIndex, nPage);
+
+                        MemQueueItems mqi;
+                        mqi.pcb = msg.procIndex;
+                        mqi.address = address;
+                        mqi.page = nPage;
+                        mqi.offset = nOffset;
+                        mqi.isWrite = isWrite;
+                        mqi.isCleaning = false;
+                        mqi.frame = -1;
+                        // The hits so far go back along with the fault
+                        faultReply[msg.procIndex] = reply;
+                        // Add approx 14 ms for each read/write
+                        AdvanceSimClock(ossHeader, 14000000);
+                        faultStartSim[msg.procIndex] = nStartSim;
+                        faultStartWall[msg.procIndex] = nStartWall;
+                        faultDirty[msg.procIndex] = false;
+                        devices.submit(mqi, GetSimClock(ossHeader));
+                        LOG_AT(LOGLEVEL_VERBOSE, "OSS  ", GetSimClock(ossHeader), "Received Memory Request " + GetStringFromInt(address) + " Not Found\n\t Page Fault - Queued for Retreival", 
+                            msg.procPid, msg.procIndex, strLogFile);
                     }
+                    bReplyQueued = true;
+                    break;
                 }
+
+                if(!bReplyQueued)
+                    SendToProcess(ossHeader, msgid, msg.procIndex, reply);
             }
         }
 
         // ********************************************
         // I/O Responses
         // ********************************************
-        // If we've had 14ms since last response, process next queue item
+        // Every idle device with a fault queued starts on the one its
+        // scheduler picks.  The frame is taken now, evicting a victim
+        // if memory is full, and the device is busy for as long as
+        // its seek and transfer take
         s.Wait();
-        if(ossHeader->simClockNanoseconds-nLastIOProcessTime > 14000000)
+        allocator.update(GetSimClock(ossHeader));
+        cleaner.run(memoryPager, devices, GetSimClock(ossHeader));
+        MemQueueItems mqi;
+        int nDevice;
+        while((nDevice = devices.startNext(GetSimClock(ossHeader), mqi)) > -1)
         {
-            if(!IOQueue.empty())
+            // A device with no faults waiting writes a dirty page out
+            if(mqi.isCleaning)
             {
-                MemQueueItems mqi = IOQueue.front();
-                IOQueue.pop();
-                if(mqi.address > -1 && mqi.pcb > -1)
-                {
-                    while(ossHeader->pcb[mqi.pcb].ptable[ossHeader->pcb[mqi.pcb].currentFrame].reference > 0)
-                    {
-                        // Set the reference = 0, (2nd Chance Caching)
-                        ossHeader->pcb[mqi.pcb].ptable[ossHeader->pcb[mqi.pcb].currentFrame].reference=0;
-                        // Maintain the circular reference
-                        ossHeader->pcb[mqi.pcb].currentFrame = ++ossHeader->pcb[mqi.pcb].currentFrame % pageCount;
-                    }
-                    int nFreeFrame = ossHeader->pcb[mqi.pcb].currentFrame;  // Designate the new frame
-                    // Increment the counter
-                    ossHeader->pcb[mqi.pcb].currentFrame = ++ossHeader->pcb[mqi.pcb].currentFrame % pageCount;
-
-                    // If writing to a Dirty page, add extra time for the write to memory
-                    // before we destroy the current values
-                    if(ossHeader->pcb[mqi.pcb].ptable[nFreeFrame].dirty)
-                    {
-                        ossHeader->simClockNanoseconds += 14000000;
-                        MemoryAccessesTotalTimeNS += 14000000;
-                    }
-
-                    // Now, reading the new value in
-                    ossHeader->simClockNanoseconds += 14000000;
-                    MemoryAccessesTotalTimeNS += 14000000;
-
-                    // Set the Page data
-                    ossHeader->pcb[mqi.pcb].ptable[nFreeFrame].frame = mqi.address;
-                    ossHeader->pcb[mqi.pcb].ptable[nFreeFrame].reference = 1;
-                    ossHeader->pcb[mqi.pcb].ptable[nFreeFrame].protection = rand() % 2;
-                    ossHeader->pcb[mqi.pcb].ptable[nFreeFrame].dirty = 0;
-                    ossHeader->pcb[mqi.pcb].ptable[nFreeFrame].valid = 1;
+                devices.beginCleaning(nDevice, GetSimClock(ossHeader),
+                    cleaner.startWrite(memoryPager, mqi));
+                continue;
+            }
 
-                    LogItem("OSS  ", ossHeader->simClockSeconds,
-                        ossHeader->simClockNanoseconds, "Memory Granted: Frame " + GetStringFromInt(nFreeFrame), 
-                        ossHeader->pcb[mqi.pcb].pid, mqi.pcb, strLogFile);
+            bool bWroteBack;
+            PagerEviction evicted;
+            int nFreeFrame = memoryPager.loadPage(mqi.pcb, mqi.page, mqi.isWrite,
+                GetSimClock(ossHeader), bWroteBack, &evicted);
+            if(evicted.frame > -1)
+                eventLog.write(EVENT_EVICTION, evicted.dirty ? OUTCOME_DIRTY : OUTCOME_CLEAN,
+                    GetSimClock(ossHeader), ossHeader->pcb[evicted.pcb].pid, evicted.pcb,
+                    evicted.page << pageShift, evicted.frame);
+
+            // A dirty victim is written out before the page is read in
+            devices.beginService(nDevice, GetSimClock(ossHeader), bWroteBack,
+                evicted.pcb, evicted.page);
+            faultDirty[mqi.pcb] = bWroteBack;
+            faultReply[mqi.pcb].memoryAddress = GetPhysicalAddress(nFreeFrame, mqi.offset);
+
+            // If the process is faulting along a stream, the pages it
+            // wants next come in with this one.  Pages are striped in
+            // runs, so the read stops where the stream crosses onto
+            // another device, and the prefetcher is told how far it got
+            readAhead.onFault(mqi.pcb, mqi.page, prefetchPages);
+            int nResident = 0;
+            for(int nPage : prefetchPages)
+            {
+                if(!devices.isOnDevice(nDevice, mqi.pcb, nPage))
+                    break;
+                nResident++;
+                int nFrame = memoryPager.prefetchPage(mqi.pcb, nPage, GetSimClock(ossHeader),
+                    bWroteBack, &evicted);
+                if(nFrame < 0)
+                    continue;
+                if(evicted.frame > -1)
+                    eventLog.write(EVENT_EVICTION, evicted.dirty ? OUTCOME_DIRTY : OUTCOME_CLEAN,
+                        GetSimClock(ossHeader), ossHeader->pcb[evicted.pcb].pid, evicted.pcb,
+                        evicted.page << pageShift, evicted.frame);
+                devices.addPrefetch(nDevice, mqi.pcb, nPage, bWroteBack, evicted.pcb, evicted.page);
+                LOG_AT(LOGLEVEL_VERBOSE, "OSS  ", GetSimClock(ossHeader), "Read ahead: Page " + GetStringFromInt(nPage)
+                    + " Frame " + GetStringFromInt(nFrame), ossHeader->pcb[mqi.pcb].pid, mqi.pcb, strLogFile);
+            }
+            if(!prefetchPages.empty())
+                readAhead.onReadAhead(mqi.pcb, nResident);
+        }
 
-                    LogItem(GenerateMemLayout(mqi.pcb, ossHeader->pcb[mqi.pcb]), strLogFile);
+        // With no requests waiting nothing else can happen first, so
+        // jump the clock ahead to when the next I/O completes
+        if(devices.inFlight() > 0 && ossHeader->requestsPending == 0
+            && devices.nextCompletion() > GetSimClock(ossHeader))
+            AdvanceSimClockTo(ossHeader, devices.nextCompletion());
 
-                    // Send memory response to waiting process
-                    msg.action = OK;
-                    msg.type = ossHeader->pcb[mqi.pcb].pid;
-                    msg.memoryAddress = mqi.address;
-                    int n = msgsnd(msgid, (void *) &msg, sizeof(message), 0); //IPC_NOWAIT);
-                }
-                else
-                {
-                    //*************** Error observed finding correct frame for memory
-                    LogItem("OSS  ", ossHeader->simClockSeconds,
-                        ossHeader->simClockNanoseconds, "Error observed finding correct frame for memory", 
-                        ossHeader->pcb[mqi.pcb].pid, mqi.pcb, strLogFile);
-                    isShutdown = true;
-                }
+        // Answer every process whose page has arrived
+        while((nDevice = devices.completeNext(GetSimClock(ossHeader), mqi)) > -1)
+        {
+            if(mqi.isCleaning)
+            {
+                cleaner.onWritten(mqi);
+                continue;
+            }
+            if(mqi.address > -1 && mqi.pcb > -1)
+            {
+                PCB& pcb = ossHeader->pcb[mqi.pcb];
+                message& reply = faultReply[mqi.pcb];
+                int nFrame = GetFrameNumber(reply.memoryAddress);
+                eventLog.write(EVENT_PAGE_LOADED, OUTCOME_NONE, GetSimClock(ossHeader),
+                    pcb.pid, mqi.pcb, mqi.page << pageShift, nFrame);
+
+                LOG_AT(LOGLEVEL_VERBOSE, "OSS  ", GetSimClock(ossHeader), "Memory Granted: Page " + GetStringFromInt(mqi.page) + " Frame " + GetStringFromInt(nFrame)
+                    + " Device " + GetStringFromInt(nDevice), pcb.pid, mqi.pcb, strLogFile);
+
+                LOG_AT(LOGLEVEL_TRACE, GenerateMemLayout(mqi.pcb, pcb, ossHeader->frameTable.get()), strLogFile);
+
+                // Send memory response to waiting process, along
+                // with any hits from earlier in its batch
+                reply.action = OK;
+                reply.procIndex = mqi.pcb;
+                if(reply.batchCount < maxBatchSize)
+                    reply.batchAddress[reply.batchCount++] = reply.memoryAddress;
+                SendToProcess(ossHeader, msgid, mqi.pcb, reply);
+
+                const int nOutcome = faultDirty[mqi.pcb] ? LATENCY_DIRTY_FAULT : LATENCY_CLEAN_FAULT;
+                simLatency[nOutcome].record(GetSimClock(ossHeader) - faultStartSim[mqi.pcb]);
+                wallLatency[nOutcome].record(GetWallTimeNS() - faultStartWall[mqi.pcb]);
+            }
+            else
+            {
+                //*************** Error observed finding correct frame for memory
+                LOG_AT(LOGLEVEL_ERROR, "OSS  ", GetSimClock(ossHeader), "Error observed finding correct frame for memory", 
+                    ossHeader->pcb[mqi.pcb].pid, mqi.pcb, strLogFile);
+                isShutdown = true;
             }
         }
         s.Signal();
@@ -525,10 +790,31 @@ int ossProcess(string strLogFile, int nProcessesRequested)
 
     s.Wait();
     // Get the stats from the shared memory before we break it down
-    nTotalTime = ossHeader->simClockSeconds;
+    fltTotalTime = (double)GetSimClock(ossHeader) / 1000000000.0;
+    for(int i=0; i < nProcessesRequested; i++)
+    {
+        nTlbHits += ossHeader->pcb[i].tlbHits;
+        nTlbMisses += ossHeader->pcb[i].tlbMisses;
+        // TLB hits take no sim time
+        wallLatency[LATENCY_TLB_HIT].merge(ossHeader->tlbHitLatency[i]);
+    }
+    simLatency[LATENCY_TLB_HIT].record(0, nTlbHits);
+    // TLB hits are memory accesses oss never sees
+    nNumberMemoryAccesses += nTlbHits;
+
+    LOG_AT(LOGLEVEL_INFO, "________________________________\n", strLogFile);
+    LOG_AT(LOGLEVEL_INFO, "OSS: Physical memory frames in use (" + GetStringFromInt(memoryPager.framesInUse()) + " of " + GetStringFromInt(totalMemory) + ")", strLogFile);
+    // Too many frames makes the map unreadable
+    if(totalMemory <= memoryMapFramesMax)
+        LOG_AT(LOGLEVEL_INFO, memoryPager.getMemoryMap().showAsTable(32), strLogFile);
+
+    // Write out the rest of the logs - the log area goes away
+    // with the shared memory
+    logger.stop();
+    logArea = NULL;
 
-    LogItem("________________________________\n", strLogFile);
-    LogItem("OSS: De-allocating shared memory", strLogFile);
+    LOG_AT(LOGLEVEL_INFO, "________________________________\n", strLogFile);
+    LOG_AT(LOGLEVEL_INFO, "OSS: De-allocating shared memory", strLogFile);
 
     if (shmdt(shm_addr) == -1) {
         perror("OSS: Error detaching shared memory");
@@ -538,33 +824,121 @@ int ossProcess(string strLogFile, int nProcessesRequested)
     if (shmctl(shm_id, IPC_RMID, NULL) == -1) {
         perror("OSS: Error deallocating shared memory ");
     }
-    LogItem("OSS: Shared memory De-allocated", strLogFile);
+    LOG_AT(LOGLEVEL_INFO, "OSS: Shared memory De-allocated", strLogFile);
 
     // Destroy the Message Queue
     msgctl(msgid,IPC_RMID,NULL);
 
-    LogItem("OSS: Message Queue De-allocated", strLogFile);
+    if(eventLog.isOpen())
+    {
+        uint64_t nRecords = eventLog.getRecordCount();
+        if(!eventLog.close())
+            perror("OSS: Error writing event log");
+        LOG_AT(LOGLEVEL_INFO, "OSS: Event log written to " + options.strEventLogFile + " ("
+            + to_string(nRecords) + " events)", strLogFile);
+    }
+    if(trace.isOpen())
+    {
+        uint64_t nRecords = trace.getRecordCount();
+        if(!trace.close())
+            perror("OSS: Error writing trace file");
+        LOG_AT(LOGLEVEL_INFO, "OSS: Trace recorded to " + options.strTraceRecordFile + " ("
+            + to_string(nRecords) + " references)", strLogFile);
+    }
+
+    close(epollFd);
+    close(requestFd);
+    close(sigFd);
+
+    LOG_AT(LOGLEVEL_INFO, "OSS: Message Queue De-allocated", strLogFile);
 
 
-    // Calc & Report the statistics
-    if(nTotalTime > 0)
+    // Calc & Report the statistics - these are logged at every level
+    if(fltTotalTime > 0)
     {
         LogItem("________________________________\n", strLogFile);
         LogItem("OSS Statistics", strLogFile);
-        float fltStat = (float)nNumberMemoryAccesses / (float)nTotalTime;
+        LogItem("Page replacement policy:\t\t\t\t" + string(replacement->getName()), strLogFile);
+        float fltStat = (float)((double)nNumberMemoryAccesses / fltTotalTime);
         LogItem("Number of memory accesses per second:\t\t\t" + GetStringFromFloat(fltStat), strLogFile);
 
-        fltStat = (float)nNumberPageFaults / (float)nNumberMemoryAccesses;
+        fltStat = nNumberMemoryAccesses ? (float)nNumberPageFaults / (float)nNumberMemoryAccesses : 0.0f;
         LogItem("Number of page faults per memory access:\t\t" + GetStringFromFloat(fltStat), strLogFile);
-        
-        fltStat = (float)nNumberMemoryAccesses/(float)MemoryAccessesTotalTimeS;
-        LogItem("Average memory access speed:\t\t\t\t" + GetStringFromFloat(fltStat) + " Kbps", strLogFile);
-        
-        fltStat = (float)nNumberSegFaults / (float)nNumberMemoryAccesses;
+
+        fltStat = nNumberMemoryAccesses ? (float)nNumberSegFaults / (float)nNumberMemoryAccesses : 0.0f;
         LogItem("Number of seg faults per memory access:\t\t\t" + GetStringFromFloat(fltStat), strLogFile);
+        LogItem("Number of page evictions:\t\t\t\t" + to_string(memoryPager.getEvictions()), strLogFile);
+        fltStat = (float)((double)nNumberPageFaults / fltTotalTime);
+        LogItem("Number of page faults per second:\t\t\t" + GetStringFromFloat(fltStat), strLogFile);
+
+        // How much of the read-ahead got used before it was evicted
+        if(readAhead.isEnabled())
+        {
+            long nUsed = readAhead.getUsed();
+            long nWasted = readAhead.getWasted();
+            fltStat = nUsed + nWasted > 0 ? (float)nUsed / (float)(nUsed + nWasted) : 0.0f;
+            LogItem("Pages read ahead / used / wasted:\t\t\t" + to_string(memoryPager.getPrefetches())
+                + " / " + to_string(nUsed) + " / " + to_string(nWasted), strLogFile);
+            LogItem("Read-ahead accuracy (used / used+wasted):\t\t" + GetStringFromFloat(fltStat), strLogFile);
+        }
+
+        // Frames moved to processes under their quota, and victims
+        // a process had to find among its own pages
+        if(allocator.isEnabled())
+            LogItem("Frame allocation / updates / shifted / local:\t\t" + string(allocator.getName())
+                + " / " + to_string(allocator.getUpdates()) + " / " + to_string(allocator.getShifted())
+                + " / " + to_string(memoryPager.getLocalEvictions()), strLogFile);
+
+        // Dirty victims written while a process waited, against those
+        // the cleaner wrote ahead of time
+        LogItem("Dirty page writebacks forced / proactive:\t\t" + to_string(memoryPager.getWritebacks())
+            + " / " + to_string(cleaner.getWritten()), strLogFile);
+        if(cleaner.isEnabled())
+            LogItem("Cleaner writes skipped (page already gone):\t\t" + to_string(cleaner.getSkipped()), strLogFile);
+
+        // How busy each paging device was
+        LogItem("Paging devices / I/O scheduler:\t\t\t\t" + GetStringFromInt(devices.getDeviceCount())
+            + " / " + devices.getSchedulerName(), strLogFile);
+        for(int i = 0; i < devices.getDeviceCount(); i++)
+        {
+            const PagingDeviceStats& stats = devices.getStats(i);
+            float fltWaitMS = stats.nServed > 0 ? (float)stats.waitNS / (float)stats.nServed / 1000000.0f : 0.0f;
+            float fltServiceMS = stats.nServed > 0 ? (float)stats.serviceNS / (float)stats.nServed / 1000000.0f : 0.0f;
+            float fltBusy = (float)((double)stats.serviceNS / (fltTotalTime * 1000000000.0));
+            LogItem("  Device " + GetStringFromInt(i) + ": " + to_string(stats.nServed) + " served, "
+                + to_string(stats.nWritebacks) + " writebacks, " + to_string(stats.nPrefetched)
+                + " read ahead, " + to_string(stats.nCleaned) + " cleaned, wait " + GetStringFromFloat(fltWaitMS)
+                + " ms, service " + GetStringFromFloat(fltServiceMS) + " ms, busy "
+                + GetStringFromFloat(fltBusy * 100.0f) + "%, max queue " + to_string(stats.nMaxQueue), strLogFile);
+        }
+
+        LogItem("Number of TLB hits:\t\t\t\t\t" + to_string(nTlbHits), strLogFile);
+        LogItem("Number of TLB misses:\t\t\t\t\t" + to_string(nTlbMisses), strLogFile);
+        fltStat = (nTlbHits + nTlbMisses > 0) ? (float)nTlbHits / (float)(nTlbHits + nTlbMisses) : 0.0f;
+        LogItem("TLB hit ratio:\t\t\t\t\t\t" + GetStringFromFloat(fltStat), strLogFile);
+
+        // Tail latency by outcome - every access is in exactly one
+        LogItem("Access latency\t\tcount\t\tp50\t\tp90\t\tp99\t\tp99.9\t\tmax", strLogFile);
+        latencyHistogram simAll, wallAll;
+        for(int i = 0; i < LATENCY_OUTCOME_COUNT; i++)
+        {
+            LogItem(string("  ") + latencyOutcomeNames[i] + " (sim ms)\t"
+                + FormatLatency(simLatency[i], 1000000.0, "ms"), strLogFile);
+            LogItem(string("  ") + latencyOutcomeNames[i] + " (wall us)\t"
+                + FormatLatency(wallLatency[i], 1000.0, "us"), strLogFile);
+            simAll.merge(simLatency[i]);
+            wallAll.merge(wallLatency[i]);
+        }
+        LogItem("  All (sim ms)\t\t" + FormatLatency(simAll, 1000000.0, "ms"), strLogFile);
+        LogItem("  All (wall us)\t\t" + FormatLatency(wallAll, 1000.0, "us"), strLogFile);
+        LogItem("Mean memory access time:\t\t\t\t" + GetStringFromFloat((float)(simAll.getMean() / 1000000.0))
+            + " ms", strLogFile);
+        LogItem("Number of log lines written:\t\t\t\t" + to_string(logger.getLinesWritten()), strLogFile);
+        LogItem("Number of log lines dropped:\t\t\t\t" + to_string(logger.getLinesDropped()), strLogFile);
     }
     s.Signal();
     cout << endl;
+    delete replacement;
 
     // Success!
     return EXIT_SUCCESS;
@@ -581,11 +955,14 @@ int forkProcess(string strProcess, string strLogFile, int nArrayItem)
             // Signal to any child process to exit
 
             perror("OSS: Could not fork process");
-            return EXIT_FAILURE;
+            return -1;
         }
         // Child process here - Assign out it's work
         if(pid == 0)
         {
+            // Children get SIGINT back
+            sigprocmask(SIG_SETMASK, &origSigMask, NULL);
+
             // Execute child process without array arguements
             if(nArrayItem < 0)
               execl(strProcess.c_str(), strProcess.c_str(), strLogFile.c_str(), "50", (char*)0);
@@ -603,22 +980,41 @@ int forkProcess(string strProcess, string strLogFile, int nArrayItem)
             return pid; // Returns the Parent PID
 }
 
-string GenerateMemLayout(const int index, const PCB& pcb)
+string GenerateMemLayout(const int index, const PCB& pcb, const FrameTableEntry* frameTable)
 {
+    // Reference and dirty come from the frame table - that is
+    // what the replacement policy works from
     string strReturn = "PCB ";
     strReturn.append(GetStringFromInt(index));
-    strReturn.append("\tOcc\tRef\tDirty\n");
+    strReturn.append("\tOcc\tRef\tDirty\tFrame\n");
     for(int i=0; i < pageCount; i++)
     {
-        strReturn.append("Fr ");
+        const FrameTableEntry* fte = pcb.ptable[i].isValid() ? &frameTable[pcb.ptable[i].getFrame()] : NULL;
+        strReturn.append("Pg ");
         strReturn.append(GetStringFromInt(i));
         strReturn.append("\t");
-        strReturn.append(GetStringFromInt(pcb.ptable[i].valid));
+        strReturn.append(GetStringFromInt(pcb.ptable[i].isValid()));
         strReturn.append("\t");
-        strReturn.append(GetStringFromInt(pcb.ptable[i].reference));
+        strReturn.append(GetStringFromInt(fte ? fte->reference : 0));
         strReturn.append("\t");
-        strReturn.append(GetStringFromInt(pcb.ptable[i].dirty));
+        strReturn.append(GetStringFromInt(fte ? fte->dirty : 0));
+        strReturn.append("\t");
+        strReturn.append(fte ? GetStringFromInt(pcb.ptable[i].getFrame()) : "-");
         strReturn.append("\n");
     }
     return strReturn;
-}
\ No newline at end of file
+}
+
+
+// One row of the latency table - the count, then the percentiles
+// and max divided down to the units shown
+string FormatLatency(const latencyHistogram& histogram, double fltDivisor, const char* strUnits)
+{
+    string strRow = to_string(histogram.getCount());
+    strRow.append(strRow.size() < 8 ? "\t\t" : "\t");
+    const double percentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+    for(double fltPercent : percentiles)
+        strRow.append(string_format("%.3f\t\t", histogram.getPercentile(fltPercent) / fltDivisor));
+    strRow.append(string_format("%.3f %s", histogram.getMax() / fltDivisor, strUnits));
+    return strRow;
+}
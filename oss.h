@@ -13,11 +13,72 @@
 #define OSS_H
 
 #include <string>
+#include <stdint.h>
 //#include "sharedStructures.h"
 
 using namespace std;
 
+// Run-time options for oss, set from the command line
+struct OssOptions {
+    bool useMessageQueue = false;   // System V message queue instead of shared memory rings
+    std::string strReplacementPolicy = "clock"; // Page replacement policy name
+    std::string strTraceRecordFile;     // Record every reference to this trace
+    std::string strTraceReplayFile;     // Replay this trace instead of running processes
+    bool useCompare = false;            // Replay through every policy and OPT
+    std::string strEventLogFile;        // Binary event log for ossdump
+    int nLogLevel = 1;                  // LogLevel - info
+    int nLogFlushMS = 100;              // Longest log lines wait to be written out
+    int nBatchSize = 1;                 // References user_proc sends per request
+    int nFrames = 256;                  // Physical frames
+    int nPages = 32;                    // Pages per process
+    int nPageSize = 1024;               // Bytes per page - a power of 2
+    int nPagingDevices = 1;             // Swap devices page faults are spread over
+    std::string strIOScheduler = "fifo";    // I/O scheduler each paging device uses
+    int nPrefetchWindow = 0;            // Most pages read ahead per fault - 0 is off
+    int nCleanerLowWater = 50;          // Percent of frames kept clean - 0 is off
+    bool useThreadEngine = false;       // Simulate processes in-process on threads
+    long nEngineReferences = 10000000;  // References the in-process engine makes
+    int nEngineThreads = 1;             // Engine worker threads
+    float fltWriteProbability = 0.35f;  // Chance an engine reference is a write
+    unsigned int nEngineSeed = 0;       // Engine random seed - 0 to seed from the clock
+    std::string strWorkload = "uniform";    // Reference pattern - see ParseWorkload
+    std::string strFrameAllocation = "global";  // Frames per process - see ParseFrameAllocation
+};
+
+// What one run of the in-process engine did
+struct EngineResults {
+    int nFrames = 0;
+    int nThreads = 0;
+    long nProcesses = 0;            // Processes run, including replacements
+    long nMemoryAccesses = 0;
+    long nPageFaults = 0;
+    long nSegFaults = 0;
+    long nEvictions = 0;
+    long nWritebacks = 0;
+    uint64_t nSimTimeNS = 0;
+    long nWallTimeNS = 0;
+    double fltLatencyMeanNS = 0;    // Sim time a reference waited
+    uint64_t nLatencyP50NS = 0;
+    uint64_t nLatencyP90NS = 0;
+    uint64_t nLatencyP99NS = 0;
+    uint64_t nLatencyP999NS = 0;
+    uint64_t nLatencyMaxNS = 0;
+};
+
 // ossProcess - Process to start oss process.
-int ossProcess(std::string, int);
+int ossProcess(std::string, int, const OssOptions&);
+
+// ossReplay - Replay a recorded reference trace (ossReplay.cpp)
+int ossReplay(std::string, const OssOptions&);
+
+// ossCompare - Compare every policy and OPT over a trace (ossReplay.cpp)
+int ossCompare(std::string, const OssOptions&);
+
+// ossEngine - Run the in-process threaded engine (ossEngine.cpp)
+int ossEngine(int, const OssOptions&);
+
+// RunEngine - Run the engine without reporting.  Returns false if
+// the options can't be run (ossEngine.cpp)
+bool RunEngine(int, const OssOptions&, EngineResults&);
 
 #endif // OSS_H
\ No newline at end of file
@@ -0,0 +1,262 @@
+/********************************************
+ * ossEngine - Memory Management (oss) Application
+ * The in-process simulation engine (oss -e).
+ * Instead of forking a user_proc for every
+ * simulated process, the processes are tasks
+ * run by a few worker threads.  They make the
+ * same kind of references user_proc does and
+ * hand them to the pager with a function call,
+ * so there is no IPC in the way.
+ *
+ * Brett Huffman
+ * ossEngine CPP file for oss project
+ ********************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include "pager.h"
+#include "latencyHistogram.h"
+#include "workload.h"
+#include "oss.h"
+
+using namespace std;
+
+// The same reference pattern user_proc makes.  The chance of a
+// write comes from the options
+const float engineShutdownProbability = 0.001f; // Chance a process ends
+const float engineSegFaultProbability = 0.001f; // Chance of an illegal address
+// Sim time for a disk read or write
+const uint64_t engineDiskTimeNS = 14000000;
+// References a worker claims from the total at a time
+const long engineClaimSize = 1024;
+
+// Shared by all the workers.  The pager is not thread safe,
+// so everything it touches is behind pagerLock
+struct EngineState {
+    pager* memoryPager;
+    float fltWriteProbability;
+    WorkloadParams workload;
+    mutex pagerLock;
+    uint64_t simClockNS;            // Under pagerLock
+    atomic<long> referencesLeft;
+};
+
+// Each worker keeps its own counts and they are added up at the end
+struct EngineCounts {
+    long nMemoryAccesses = 0;
+    long nPageFaults = 0;
+    long nSegFaults = 0;
+    long nProcesses = 0;
+    latencyHistogram latency;       // Sim time each reference waited
+};
+
+// Returns a monotonic timestamp in nanoseconds
+static long GetEngineTimeNS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// EngineWorker - runs the simulated processes in slots round-robin,
+// one reference each per turn, until the references run out.
+// Each process has its own reference generator
+static void EngineWorker(EngineState* state, vector<int> slots, unsigned int seed, EngineCounts* counts)
+{
+    long nClaimed = 0;
+    counts->nProcesses = slots.size();
+    vector<workloadGenerator> processes;
+    for(int nPcb : slots)
+        processes.push_back(workloadGenerator(state->workload, seed + nPcb * 7919));
+    while(true)
+    {
+        for(size_t i = 0; i < slots.size(); i++)
+        {
+            if(nClaimed == 0)
+            {
+                nClaimed = min(engineClaimSize, state->referencesLeft.fetch_sub(engineClaimSize));
+                if(nClaimed <= 0)
+                    return;
+            }
+            nClaimed--;
+
+            const int nPcb = slots[i];
+            workloadGenerator& workload = processes[i];
+            workloadRandom& random = workload.random();
+            const uint64_t nThinkTime = random.between(1000, 500000);
+
+            // A process that ends is replaced by a new one in its slot
+            if(random.chance(engineShutdownProbability))
+            {
+                lock_guard<mutex> guard(state->pagerLock);
+                state->simClockNS += nThinkTime;
+                state->memoryPager->resetProcess(nPcb);
+                workload.restart();
+                counts->nProcesses++;
+                continue;
+            }
+
+            uint address = workload.nextAddress();
+            if(random.chance(engineSegFaultProbability))
+                address += random.below(processSize);
+            const bool isWrite = random.chance(state->fltWriteProbability);
+
+            counts->nMemoryAccesses++;
+            lock_guard<mutex> guard(state->pagerLock);
+            const uint64_t now = (state->simClockNS += nThinkTime);
+            int nFrame;
+            PagerResult result = state->memoryPager->access(nPcb, address, isWrite, now, nFrame);
+            if(result == PAGE_FAULT)
+            {
+                // The process waits while the page is read in
+                bool bWroteBack;
+                counts->nPageFaults++;
+                state->memoryPager->loadPage(nPcb, GetPageNumber(address), isWrite, now, bWroteBack);
+                const uint64_t nWaitNS = bWroteBack ? 2 * engineDiskTimeNS : engineDiskTimeNS;
+                state->simClockNS += nWaitNS;
+                counts->latency.record(nWaitNS);
+            }
+            else if(result == PAGE_SEGFAULT)
+            {
+                // oss kills the process, and a new one takes its place
+                counts->nSegFaults++;
+                counts->nProcesses++;
+                state->memoryPager->resetProcess(nPcb);
+                workload.restart();
+            }
+            else
+                counts->latency.record(0);
+        }
+    }
+}
+
+// RunEngine - run nProcesses simulated processes on worker threads
+// for options.nEngineReferences references and fill in results
+bool RunEngine(int nProcesses, const OssOptions& options, EngineResults& results)
+{
+    if(!SetProcessCount(nProcesses))
+    {
+        errno = EINVAL;
+        perror("OSS: Unusable process count");
+        results = EngineResults();
+        return false;
+    }
+    // With one worker the processes take strict turns.  With more,
+    // how their references interleave is up to the OS scheduler
+    const int nThreads = max(1, min(options.nEngineThreads, nProcesses));
+    // The geometry can differ from run to run in a sweep
+    if(!SetMemoryGeometry(options.nFrames, options.nPages, options.nPageSize))
+    {
+        errno = EINVAL;
+        perror("OSS: Unusable memory geometry");
+        results = EngineResults();
+        return false;
+    }
+    const int nFrames = totalMemory;
+    WorkloadParams workload;
+    if(!ParseWorkload(options.strWorkload, workload))
+    {
+        errno = EINVAL;
+        perror("OSS: Unknown workload");
+        results = EngineResults();
+        return false;
+    }
+
+    PCB* pcbs = NewPcbs(processesMax);
+    FrameTableEntry* frameTable = new FrameTableEntry[nFrames];
+    pageReplacement* replacement = CreatePageReplacement(options.strReplacementPolicy,
+        frameTable, nFrames);
+
+    EngineState state;
+    state.memoryPager = new pager(pcbs, processesMax, frameTable, nFrames, replacement);
+    state.fltWriteProbability = options.fltWriteProbability;
+    state.workload = workload;
+    state.simClockNS = 0;
+    state.referencesLeft = options.nEngineReferences;
+    for(int i = 0; i < processesMax; i++)
+        state.memoryPager->resetProcess(i);
+
+    // Deal the process slots out to the workers
+    vector<vector<int> > slots(nThreads);
+    for(int i = 0; i < nProcesses; i++)
+        slots[i % nThreads].push_back(i);
+
+    vector<EngineCounts> counts(nThreads);
+    vector<thread> workers;
+    unsigned int seed = options.nEngineSeed ? options.nEngineSeed : time(0) ^ getpid();
+    long startTime = GetEngineTimeNS();
+    for(int i = 0; i < nThreads; i++)
+        workers.push_back(thread(EngineWorker, &state, slots[i], seed, &counts[i]));
+    for(size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    results = EngineResults();
+    results.nWallTimeNS = GetEngineTimeNS() - startTime;
+    results.nFrames = nFrames;
+    results.nThreads = nThreads;
+    latencyHistogram latency;
+    for(int i = 0; i < nThreads; i++)
+    {
+        results.nMemoryAccesses += counts[i].nMemoryAccesses;
+        results.nPageFaults += counts[i].nPageFaults;
+        results.nSegFaults += counts[i].nSegFaults;
+        results.nProcesses += counts[i].nProcesses;
+        latency.merge(counts[i].latency);
+    }
+    results.nSimTimeNS = state.simClockNS;
+    results.nEvictions = state.memoryPager->getEvictions();
+    results.nWritebacks = state.memoryPager->getWritebacks();
+    results.fltLatencyMeanNS = latency.getMean();
+    results.nLatencyP50NS = latency.getPercentile(50.0);
+    results.nLatencyP90NS = latency.getPercentile(90.0);
+    results.nLatencyP99NS = latency.getPercentile(99.0);
+    results.nLatencyP999NS = latency.getPercentile(99.9);
+    results.nLatencyMaxNS = latency.getMax();
+
+    delete state.memoryPager;
+    delete replacement;
+    delete [] frameTable;
+    DeletePcbs(pcbs);
+    return true;
+}
+
+// ossEngine - run the engine and report the results
+int ossEngine(int nProcesses, const OssOptions& options)
+{
+    EngineResults results;
+    if(!RunEngine(nProcesses, options, results))
+        return EXIT_FAILURE;
+    const double fltSimSeconds = (double)results.nSimTimeNS / 1000000000.0;
+
+    cout << fixed << setprecision(4);
+    cout << "OSS In-Process Engine Statistics" << endl;
+    cout << "Page replacement policy:\t\t\t" << options.strReplacementPolicy << endl;
+    cout << "Frames:\t\t\t\t\t\t" << results.nFrames << endl;
+    cout << "Worker threads:\t\t\t\t\t" << results.nThreads << endl;
+    cout << "Number of processes run:\t\t\t" << results.nProcesses << endl;
+    cout << "Sim time covered:\t\t\t\t" << fltSimSeconds << " s" << endl;
+    cout << "Number of memory accesses:\t\t\t" << results.nMemoryAccesses << endl;
+    cout << "Number of memory accesses per second:\t\t"
+         << (fltSimSeconds > 0 ? results.nMemoryAccesses / fltSimSeconds : 0.0) << endl;
+    cout << "Number of page faults per memory access:\t"
+         << (results.nMemoryAccesses ? (double)results.nPageFaults / results.nMemoryAccesses : 0.0) << endl;
+    cout << "Number of seg faults per memory access:\t\t"
+         << (results.nMemoryAccesses ? (double)results.nSegFaults / results.nMemoryAccesses : 0.0) << endl;
+    cout << "Number of page evictions:\t\t\t" << results.nEvictions << endl;
+    cout << "Number of dirty page writebacks:\t\t" << results.nWritebacks << endl;
+    cout << "Access latency mean / p99 / max:\t\t" << results.fltLatencyMeanNS / 1000000.0 << " / "
+         << results.nLatencyP99NS / 1000000.0 << " / " << results.nLatencyMaxNS / 1000000.0 << " ms" << endl;
+    cout << "Wall time:\t\t\t\t\t" << (double)results.nWallTimeNS / 1000000.0 << " ms" << endl;
+    cout << "Simulated references per second:\t\t"
+         << (results.nWallTimeNS > 0 ? (double)results.nMemoryAccesses * 1000000000.0 / results.nWallTimeNS : 0.0) << endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+/********************************************
+ * ossReplay - Memory Management (oss) Application
+ * Replays a memory reference trace recorded by
+ * oss -t.  No user processes are started - the
+ * references are fed straight to the pager in
+ * recorded order, so every run of a trace gives
+ * the same results and policies and builds can
+ * be compared against each other.  The
+ * comparison mode runs every policy and
+ * Belady's OPT over the same trace.
+ *
+ * Brett Huffman
+ * ossReplay CPP file for oss project
+ ********************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "traceFile.h"
+#include "pager.h"
+#include "beladyOracle.h"
+#include "oss.h"
+
+using namespace std;
+
+// Returns a monotonic timestamp in nanoseconds
+static long GetReplayTimeNS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// Opens a trace and switches to the geometry and process count it
+// was recorded with
+static bool OpenTrace(traceReader& trace, std::string strTraceFile)
+{
+    if(!trace.open(strTraceFile))
+    {
+        perror("OSS: Could not open trace file");
+        return false;
+    }
+    // Replay with the address space the trace was recorded with,
+    // or every reference past the end of ours would seg fault
+    const TraceFileHeader& header = trace.getHeader();
+    if((header.pageSize != (uint32_t)pageSize || header.pageCount != (uint32_t)pageCount)
+        && !SetMemoryGeometry(totalMemory, header.pageCount, header.pageSize))
+    {
+        errno = EINVAL;
+        perror("OSS: Trace was recorded with an unusable page size or page count");
+        return false;
+    }
+    // and with as many PCB slots
+    if(!SetProcessCount(header.processCount))
+    {
+        errno = EINVAL;
+        perror("OSS: Trace was recorded with an unusable process count");
+        return false;
+    }
+
+    // Read it through once, so a damaged trace is refused before
+    // anything is replayed
+    TraceRecord rec;
+    while(trace.next(rec))
+        ;
+    if(trace.isCorrupt())
+    {
+        errno = EINVAL;
+        perror("OSS: Trace has a record that is cut short or out of range");
+        return false;
+    }
+    trace.rewind();
+    return true;
+}
+
+// Feeds the whole trace through the pager with the named
+// replacement policy
+static void ReplayTrace(traceReader& trace, std::string strPolicy, ReplayStats& stats)
+{
+    stats = ReplayStats(processesMax);
+
+    // Same fixed seed every run so the replay is repeatable
+    srand(1);
+
+    // The pager works on plain memory here - nothing is shared
+    PCB* pcbs = NewPcbs(processesMax);
+    FrameTableEntry* frameTable = new FrameTableEntry[totalMemory];
+    pageReplacement* replacement = CreatePageReplacement(strPolicy, frameTable, totalMemory);
+    pager memoryPager(pcbs, processesMax, frameTable, totalMemory, replacement);
+    for(int i = 0; i < processesMax; i++)
+        memoryPager.resetProcess(i);
+
+    TraceRecord rec;
+    trace.rewind();
+    while(trace.next(rec))
+    {
+        stats.nLastSimTime = rec.simTime;
+        if(rec.procIndex < 0 || rec.procIndex >= processesMax)
+        {
+            stats.nSegFaults++;
+            continue;
+        }
+        if(rec.type == TRACE_EXIT)
+        {
+            stats.nProcessExits++;
+            memoryPager.resetProcess(rec.procIndex);
+            continue;
+        }
+
+        // Faults are serviced as soon as they happen
+        stats.nAccesses++;
+        stats.processAccesses[rec.procIndex]++;
+        const bool isWrite = rec.type == TRACE_WRITE;
+        int nFrame;
+        PagerResult result = memoryPager.access(rec.procIndex, rec.address, isWrite, rec.simTime, nFrame);
+        if(result == PAGE_SEGFAULT)
+            stats.nSegFaults++;
+        else if(result == PAGE_FAULT)
+        {
+            bool bWroteBack;
+            stats.nFaults++;
+            stats.processFaults[rec.procIndex]++;
+            memoryPager.loadPage(rec.procIndex, GetPageNumber(rec.address), isWrite, rec.simTime, bWroteBack);
+        }
+    }
+    stats.nEvictions = memoryPager.getEvictions();
+    stats.nWritebacks = memoryPager.getWritebacks();
+
+    delete replacement;
+    delete [] frameTable;
+    DeletePcbs(pcbs);
+}
+
+// ossReplay - replay strTraceFile through the replacement policy
+// picked in options and report the results
+int ossReplay(std::string strTraceFile, const OssOptions& options)
+{
+    traceReader trace;
+    if(!OpenTrace(trace, strTraceFile))
+        return EXIT_FAILURE;
+
+    ReplayStats stats;
+    long startTime = GetReplayTimeNS();
+    ReplayTrace(trace, options.strReplacementPolicy, stats);
+    long totalTime = GetReplayTimeNS() - startTime;
+
+    cout << fixed << setprecision(4);
+    cout << "OSS Trace Replay: " << strTraceFile << endl;
+    cout << "Page replacement policy:\t\t\t" << options.strReplacementPolicy << endl;
+    cout << "Sim time covered:\t\t\t\t" << (double)stats.nLastSimTime / 1000000000.0 << " s" << endl;
+    cout << "Number of memory accesses:\t\t\t" << stats.nAccesses << endl;
+    cout << "Number of process exits:\t\t\t" << stats.nProcessExits << endl;
+    cout << "Number of page faults:\t\t\t\t" << stats.nFaults << endl;
+    cout << "Number of page faults per memory access:\t"
+         << (stats.nAccesses ? (double)stats.nFaults / stats.nAccesses : 0.0) << endl;
+    cout << "Number of seg faults:\t\t\t\t" << stats.nSegFaults << endl;
+    cout << "Number of page evictions:\t\t\t" << stats.nEvictions << endl;
+    cout << "Number of dirty page writebacks:\t\t" << stats.nWritebacks << endl;
+    cout << "Replay time:\t\t\t\t\t" << (double)totalTime / 1000000.0 << " ms" << endl;
+    cout << "Replayed references per second:\t\t\t"
+         << (totalTime > 0 ? (double)stats.nAccesses * 1000000000.0 / totalTime : 0.0) << endl;
+    return EXIT_SUCCESS;
+}
+
+// ossCompare - replay strTraceFile through every replacement policy
+// and Belady's OPT, and report how far each policy is from optimal
+int ossCompare(std::string strTraceFile, const OssOptions& options)
+{
+    traceReader trace;
+    if(!OpenTrace(trace, strTraceFile))
+        return EXIT_FAILURE;
+
+    vector<string> policies = GetPageReplacementNameList();
+    vector<ReplayStats> stats(policies.size());
+    for(size_t i = 0; i < policies.size(); i++)
+        ReplayTrace(trace, policies[i], stats[i]);
+
+    ReplayStats optimal;
+    long startTime = GetReplayTimeNS();
+    RunBeladyOracle(trace, totalMemory, optimal);
+    long oracleTime = GetReplayTimeNS() - startTime;
+
+    cout << fixed << setprecision(4);
+    cout << "OSS Policy Comparison: " << strTraceFile << endl;
+    cout << "Frames:\t\t\t\t\t\t" << totalMemory << endl;
+    cout << "Number of memory accesses:\t\t\t" << optimal.nAccesses << endl;
+    cout << "Number of process exits:\t\t\t" << optimal.nProcessExits << endl;
+    cout << "OPT time:\t\t\t\t\t" << (double)oracleTime / 1000000.0 << " ms" << endl << endl;
+
+    // Overall - faults over OPT is the headroom left for the policy
+    cout << "Policy\t\tFaults\t\tFault ratio\tWritebacks\tFaults over OPT" << endl;
+    cout << "opt\t\t" << optimal.nFaults << "\t\t"
+         << (optimal.nAccesses ? (double)optimal.nFaults / optimal.nAccesses : 0.0) << "\t\t"
+         << optimal.nWritebacks << "\t\t-" << endl;
+    for(size_t i = 0; i < policies.size(); i++)
+    {
+        cout << setw(12) << left << policies[i] << right << "\t" << stats[i].nFaults << "\t\t"
+             << (stats[i].nAccesses ? (double)stats[i].nFaults / stats[i].nAccesses : 0.0) << "\t\t"
+             << stats[i].nWritebacks << "\t\t";
+        if(optimal.nFaults > 0)
+            cout << setprecision(1) << 100.0 * (stats[i].nFaults - optimal.nFaults) / optimal.nFaults
+                 << "%" << setprecision(4);
+        cout << endl;
+    }
+
+    // Faults per PCB slot
+    cout << endl << "Faults per process" << endl << "PCB\tAccesses\topt";
+    for(size_t i = 0; i < policies.size(); i++)
+        cout << "\t" << policies[i].substr(0, 7);
+    cout << endl;
+    for(int nProc = 0; nProc < processesMax; nProc++)
+    {
+        if(optimal.processAccesses[nProc] == 0)
+            continue;
+        cout << nProc << "\t" << optimal.processAccesses[nProc] << "\t\t"
+             << optimal.processFaults[nProc];
+        for(size_t i = 0; i < policies.size(); i++)
+            cout << "\t" << stats[i].processFaults[nProc];
+        cout << endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -18,11 +18,21 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fstream>
+#include <sstream>
 #include "productSemaphores.h"
+#include "pageReplacement.h"
+#include "pagingDevice.h"
+#include "prefetcher.h"
+#include "asyncLog.h"
+#include "pageTable.h"
+#include "workload.h"
+#include "frameAllocator.h"
 #include "oss.h"
 
 // Forward declarations
 static void show_usage(std::string);
+static bool LoadConfigFile(std::string, OssOptions&, int&);
 
 using namespace std;
 
@@ -38,17 +48,144 @@ int main(int argc, char* argv[])
     int opt;
     string strLogFile = "logfile";
     int nProcessesRequested = 20;
+    OssOptions options;
 
     // Go through each parameter entered and
     // prepare for processing
-    while ((opt = getopt(argc, argv, "hp:")) != -1) {
+    while ((opt = getopt(argc, argv, "a:b:c:d:E:ef:g:hj:k:l:m:n:OP:p:qr:s:t:T:vW:w:z:")) != -1) {
         switch (opt) {
+            case 'f':
+                options.nLogFlushMS = atoi(optarg);
+                break;
             case 'h':
                 show_usage(argv[0]);
                 return EXIT_SUCCESS;
+            case 'b':
+                options.nBatchSize = atoi(optarg);
+                break;
+            case 'd':
+                options.nPagingDevices = atoi(optarg);
+                if(options.nPagingDevices < 1 || options.nPagingDevices > pagingDevicesMax)
+                {
+                    errno = EINVAL;
+                    perror("oss: Error: Paging devices must be 1 to 8");
+                    show_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'E':
+                options.strEventLogFile = optarg;
+                break;
+            case 'e':
+                options.useThreadEngine = true;
+                break;
+            case 'j':
+                options.nEngineThreads = atoi(optarg);
+                break;
+            case 'l':
+                options.nLogLevel = GetLogLevelFromName(optarg);
+                if(options.nLogLevel < 0)
+                {
+                    errno = EINVAL;
+                    perror("oss: Error: Unknown log level");
+                    show_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'v':
+                // Each -v logs one level more
+                options.nLogLevel = min(options.nLogLevel + 1, (int)LOGLEVEL_TRACE);
+                break;
+            case 'c':
+                if(!LoadConfigFile(optarg, options, nProcessesRequested))
+                {
+                    show_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'm':
+                options.nFrames = atoi(optarg);
+                break;
+            case 'g':
+                options.nPages = atoi(optarg);
+                break;
+            case 'z':
+                options.nPageSize = atoi(optarg);
+                break;
+            case 'w':
+                options.fltWriteProbability = atof(optarg);
+                if(options.fltWriteProbability < 0.0f || options.fltWriteProbability > 1.0f)
+                {
+                    errno = EINVAL;
+                    perror("oss: Error: Write ratio must be 0 to 1");
+                    show_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'W':
+                options.strWorkload = optarg;
+                break;
+            case 'a':
+                options.strFrameAllocation = optarg;
+                break;
+            case 'n':
+                options.nEngineReferences = atol(optarg);
+                break;
+            case 'O':
+                options.useCompare = true;
+                break;
+            case 'P':
+                options.nPrefetchWindow = atoi(optarg);
+                if(options.nPrefetchWindow < 0 || options.nPrefetchWindow > prefetchWindowMax)
+                {
+                    errno = EINVAL;
+                    perror("oss: Error: Read-ahead window must be 0 to 32");
+                    show_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'k':
+                options.nCleanerLowWater = atoi(optarg);
+                if(options.nCleanerLowWater < 0 || options.nCleanerLowWater > 100)
+                {
+                    errno = EINVAL;
+                    perror("oss: Error: Clean frame low watermark must be 0 to 100 percent");
+                    show_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
             case 'p':
                 nProcessesRequested = atoi(optarg);
                 break;
+            case 'q':
+                options.useMessageQueue = true;
+                break;
+            case 'r':
+                options.strReplacementPolicy = optarg;
+                if(!IsPageReplacementName(options.strReplacementPolicy))
+                {
+                    errno = EINVAL;
+                    perror("oss: Error: Unknown page replacement policy");
+                    show_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 's':
+                options.strIOScheduler = optarg;
+                if(!IsIOSchedulerName(options.strIOScheduler))
+                {
+                    errno = EINVAL;
+                    perror("oss: Error: Unknown I/O scheduler");
+                    show_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 't':
+                options.strTraceRecordFile = optarg;
+                break;
+            case 'T':
+                options.strTraceReplayFile = optarg;
+                break;
             case '?': // Unknown arguement                
                 if (isprint (optopt))
                 {
@@ -69,7 +206,60 @@ int main(int argc, char* argv[])
         }
     }
 
-    return ossProcess(strLogFile, nProcessesRequested);
+    // Every mode runs with this geometry
+    if(!SetMemoryGeometry(options.nFrames, options.nPages, options.nPageSize))
+    {
+        errno = EINVAL;
+        perror("oss: Error: Page size must be a power of 2 and memory must fit in 32-bit addresses");
+        show_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // and the processes, each in a PCB slot of its own
+    if(nProcessesRequested < 1 || nProcessesRequested > processesLimit)
+    {
+        errno = EINVAL;
+        perror(("oss: Error: Processes must be 1 to " + std::to_string(processesLimit)).c_str());
+        show_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // The config file can set it too, so it is checked here
+    WorkloadParams workload;
+    if(!ParseWorkload(options.strWorkload, workload))
+    {
+        errno = EINVAL;
+        perror("oss: Error: Unknown workload");
+        show_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    FrameAllocationParams allocation;
+    if(!ParseFrameAllocation(options.strFrameAllocation, allocation))
+    {
+        errno = EINVAL;
+        perror("oss: Error: Unknown frame allocation");
+        show_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // A trace replay runs on its own - no processes are started
+    if(options.useCompare && options.strTraceReplayFile.empty())
+    {
+        errno = EINVAL;
+        perror("oss: Error: -O needs a trace to replay with -T");
+        show_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if(options.useCompare)
+        return ossCompare(options.strTraceReplayFile, options);
+    if(!options.strTraceReplayFile.empty())
+        return ossReplay(options.strTraceReplayFile, options);
+
+    // So does the in-process engine
+    if(options.useThreadEngine)
+        return ossEngine(nProcessesRequested, options);
+
+    return ossProcess(strLogFile, nProcessesRequested, options);
 }
 
 
@@ -80,9 +270,85 @@ static void show_usage(std::string name)
               << name << " - oss app by Brett Huffman for CMP SCI 4760" << std::endl
               << std::endl
               << "Usage:\t" << name << " [-h]" << std::endl
-              << "\t" << name << " [-p]" << std::endl
+              << "\t" << name << " [-p] [-q] [-b n] [-f ms] [-v] [-l level] [-r policy] [-d devices] [-s scheduler] [-t tracefile] [-E eventlog]" << std::endl
+              << "\t" << name << " [-W workload] [-P window] [-k percent] [-a allocation] ..." << std::endl
+              << "\t" << name << " [-c configfile] [-m frames] [-g pages] [-z pagesize] ..." << std::endl
+              << "\t" << name << " -T tracefile [-r policy | -O]" << std::endl
+              << "\t" << name << " -e [-p] [-r policy] [-n references] [-j threads] [-m frames] [-w ratio]" << std::endl
               << "Options:" << std::endl
               << "  -h   Describe how the project should be run, then terminate" << std::endl
-              << "  -p   indicates the number of user processes in the system - default 20." << std::endl
+              << "  -p   indicates the number of user processes in the system, up to 4096 - default 20." << std::endl
+              << "  -q   use the System V message queue instead of the shared memory rings" << std::endl
+              << "  -b   memory references user_proc sends per request, up to 32 - default 1" << std::endl
+              << "  -f   milliseconds log lines can wait to be written out - default 100" << std::endl
+              << "  -v   verbose logging - every fault and process event; -vv adds every access" << std::endl
+              << "  -l   log level - error, info, verbose or trace - default info" << std::endl
+              << "  -r   page replacement policy - default clock. One of:" << std::endl
+              << "       " << GetPageReplacementNames() << std::endl
+              << "  -d   paging devices page faults are spread over, 1 to 8 - default 1" << std::endl
+              << "  -s   I/O scheduler for each paging device - default fifo. One of:" << std::endl
+              << "       " << GetIOSchedulerNames() << std::endl
+              << "  -P   most pages read ahead on a sequential or strided fault, 0 to 32," << std::endl
+              << "       e.g. 8 - default 0, off" << std::endl
+              << "  -k   percent of frames the page cleaner keeps clean by writing dirty" << std::endl
+              << "       pages out early, 0 to 100, 0 turns it off - default 50" << std::endl
+              << "  -t   record every memory reference to a binary trace file" << std::endl
+              << "  -E   write a binary log of every memory event - decode it with ossdump" << std::endl
+              << "  -T   replay a recorded trace file instead of running processes" << std::endl
+              << "  -O   with -T, replay through every policy and Belady's OPT and compare them" << std::endl
+              << "  -e   simulate the processes on threads inside oss instead of forking user_proc" << std::endl
+              << "  -n   references to simulate with -e - default 10000000" << std::endl
+              << "  -j   worker threads for -e - default 1" << std::endl
+              << "  -m   physical frames - default 256" << std::endl
+              << "  -g   pages per process - default 32" << std::endl
+              << "  -z   bytes per page, a power of 2 - default 1024" << std::endl
+              << "  -W   reference pattern of every process - default uniform. One of:" << std::endl
+              << "       " << GetWorkloadNames() << std::endl
+              << "  -a   how frames are shared between processes - default global. One of:" << std::endl
+              << "       " << GetFrameAllocationNames() << std::endl
+              << "  -c   read settings from a file of name = value lines: frames, pages," << std::endl
+              << "       pagesize, processes, workload and allocation" << std::endl
+              << "  -w   chance a reference made by -e is a write - default 0.35" << std::endl
               << std::endl << std::endl;
-}
\ No newline at end of file
+}
+// Reads name = value lines from a config file.  Blank lines and
+// lines starting with # are skipped
+static bool LoadConfigFile(std::string strFile, OssOptions& options, int& nProcessesRequested)
+{
+    ifstream file(strFile);
+    if(!file)
+    {
+        perror(("oss: Error: Could not open config file " + strFile).c_str());
+        return false;
+    }
+    string strLine;
+    while(getline(file, strLine))
+    {
+        size_t nEquals = strLine.find('=');
+        if(strLine.empty() || strLine[0] == '#' || nEquals == string::npos)
+            continue;
+        string strName, strValue;
+        stringstream(strLine.substr(0, nEquals)) >> strName;
+        stringstream(strLine.substr(nEquals + 1)) >> strValue;
+        int nValue = atoi(strValue.c_str());
+        if(strName == "frames")
+            options.nFrames = nValue;
+        else if(strName == "pages")
+            options.nPages = nValue;
+        else if(strName == "pagesize")
+            options.nPageSize = nValue;
+        else if(strName == "processes")
+            nProcessesRequested = nValue;
+        else if(strName == "workload")
+            options.strWorkload = strValue;
+        else if(strName == "allocation")
+            options.strFrameAllocation = strValue;
+        else
+        {
+            errno = EINVAL;
+            perror(("oss: Error: Unknown config setting " + strName).c_str());
+            return false;
+        }
+    }
+    return true;
+}
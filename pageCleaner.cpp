@@ -0,0 +1,89 @@
+/********************************************
+ * pageCleaner - Background dirty page writer
+ * Picks the pages to clean and tracks the
+ * writes it has queued.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * pageCleaner .cpp file for project
+ ********************************************/
+
+#include <algorithm>
+#include "pageCleaner.h"
+
+using namespace std;
+
+pageCleaner::pageCleaner(int nFrames, int nLowWaterPercent)
+    : _nLowWater(nFrames * max(0, min(nLowWaterPercent, 100)) / 100), _nHand(0),
+      _pending(nFrames), _nQueued(0), _nWritten(0), _nSkipped(0)
+{
+}
+
+void pageCleaner::run(pager& memoryPager, pagingDevices& devices, uint64_t now)
+{
+    // Free frames are clean, and so will the ones queued to be
+    // written be.  A write that has started has already marked its
+    // page clean
+    const int nFrames = memoryPager.getFrameCount();
+    int nClean = nFrames - memoryPager.dirtyFrames() + _nQueued;
+    if(_nLowWater == 0 || nClean >= _nLowWater)
+        return;
+
+    memoryPager.collectReferences(now);
+
+    // Sweep the dirty frames from where the last run stopped.  Pages
+    // referenced since the replacement policy last looked are still
+    // being written to, so they are left alone
+    int nVisited = 0;
+    bool bWrapped = false;
+    while(nClean < _nLowWater && nVisited < nFrames)
+    {
+        int nFrame = memoryPager.findDirtyFrame(_nHand);
+        if(nFrame < 0)
+        {
+            if(bWrapped)
+                break;
+            bWrapped = true;
+            _nHand = 0;
+            continue;
+        }
+        _nHand = nFrame + 1;
+        nVisited++;
+
+        const FrameTableEntry& fte = memoryPager.getFrameEntry(nFrame);
+        if(fte.reference || _pending.test(nFrame))
+            continue;
+
+        MemQueueItems item;
+        item.pcb = fte.pcb;
+        item.page = fte.page;
+        item.address = -1;
+        item.offset = 0;
+        item.isWrite = true;
+        item.isCleaning = true;
+        item.frame = nFrame;
+        // Its device may already be busy with one of ours
+        if(!devices.submitBackground(item, now))
+            continue;
+        _pending.set(nFrame);
+        _nQueued++;
+        nClean++;
+    }
+}
+
+bool pageCleaner::startWrite(pager& memoryPager, const MemQueueItems& item)
+{
+    _nQueued--;
+    if(memoryPager.cleanPage(item.frame, item.pcb, item.page))
+    {
+        _nWritten++;
+        return true;
+    }
+    _nSkipped++;
+    return false;
+}
+
+void pageCleaner::onWritten(const MemQueueItems& item)
+{
+    _pending.reset(item.frame);
+}
@@ -0,0 +1,53 @@
+/********************************************
+ * pageCleaner - Background dirty page writer
+ * Keeps enough frames clean that evictions
+ * rarely have to write a victim out while a
+ * process waits.  When clean frames fall below
+ * the low watermark it queues writes for cold
+ * dirty pages on the paging devices' low
+ * priority queues, one per device at a time.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * pageCleaner .h file for project
+ ********************************************/
+#ifndef PAGECLEANER_H
+#define PAGECLEANER_H
+
+#include <stdint.h>
+#include "bitmapper.h"
+#include "pager.h"
+#include "pagingDevice.h"
+
+class pageCleaner
+{
+    private:
+        int _nLowWater;         // Clean frames wanted, 0 if the cleaner is off
+        int _nHand;             // Where the next sweep of the dirty map starts
+        bitmapper _pending;     // Frames with a write queued or in flight
+        int _nQueued;           // Writes not started yet - their pages are still dirty
+        long _nWritten;         // Pages written ahead of eviction
+        long _nSkipped;         // Writes dropped - the page went before its turn
+
+    public:
+
+    // nLowWaterPercent of the frames are kept clean - 0 turns it off
+    pageCleaner(int nFrames, int nLowWaterPercent);
+
+    // Queue writes for cold dirty pages while too few frames are clean
+    void run(pager&, pagingDevices&, uint64_t now);
+
+    // A device is starting one of our writes.  Marks the page clean
+    // and returns true, or false if it was evicted or written out
+    // some other way while it waited
+    bool startWrite(pager&, const MemQueueItems&);
+
+    // A write has finished
+    void onWritten(const MemQueueItems&);
+
+    bool isEnabled() { return _nLowWater > 0; }
+    long getWritten() { return _nWritten; }
+    long getSkipped() { return _nSkipped; }
+};
+
+#endif // PAGECLEANER_H
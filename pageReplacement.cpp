@@ -0,0 +1,505 @@
+/********************************************
+ * pageReplacement - Page Replacement Policies
+ * Implementations of the page replacement
+ * policies oss can run with.  Each one only
+ * sees the frame table and the hooks oss calls
+ * on access, fault and eviction.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * pageReplacement .cpp file for project
+ ********************************************/
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
+#include "pageReplacement.h"
+
+using namespace std;
+
+// WSClock working set window - pages not referenced for this
+// much sim time are outside the working set
+const uint64_t wsClockTau = 50000000;
+
+/***************************************************
+ * frameLists - Intrusive doubly linked lists of
+ * frame indexes.  A frame is on at most one list
+ * at a time, so all lists share one set of links
+ * and every operation is O(1).  Front is the
+ * oldest (LRU) end, back the newest (MRU).
+ * *************************************************/
+class frameLists
+{
+    private:
+        vector<int> _prev, _next, _list;    // Per frame
+        vector<int> _head, _tail, _size;    // Per list
+
+    public:
+
+    frameLists(int nFrames, int nLists)
+        : _prev(nFrames, -1), _next(nFrames, -1), _list(nFrames, -1),
+          _head(nLists, -1), _tail(nLists, -1), _size(nLists, 0) {}
+
+    int front(int nList) { return _head[nList]; }
+    int next(int nFrame) { return _next[nFrame]; }
+    int size(int nList) { return _size[nList]; }
+    int listOf(int nFrame) { return _list[nFrame]; }
+
+    void pushBack(int nList, int nFrame)
+    {
+        remove(nFrame);
+        _prev[nFrame] = _tail[nList];
+        _next[nFrame] = -1;
+        if(_tail[nList] > -1)
+            _next[_tail[nList]] = nFrame;
+        else
+            _head[nList] = nFrame;
+        _tail[nList] = nFrame;
+        _list[nFrame] = nList;
+        _size[nList]++;
+    }
+
+    void remove(int nFrame)
+    {
+        int nList = _list[nFrame];
+        if(nList < 0)
+            return;
+        if(_prev[nFrame] > -1)
+            _next[_prev[nFrame]] = _next[nFrame];
+        else
+            _head[nList] = _next[nFrame];
+        if(_next[nFrame] > -1)
+            _prev[_next[nFrame]] = _prev[nFrame];
+        else
+            _tail[nList] = _prev[nFrame];
+        _prev[nFrame] = _next[nFrame] = _list[nFrame] = -1;
+        _size[nList]--;
+    }
+};
+
+/***************************************************
+ * FIFO - Evict the page that was loaded first
+ * *************************************************/
+class fifoReplacement : public pageReplacement
+{
+    protected:
+        frameLists _queue;
+
+    public:
+
+    fifoReplacement(FrameTableEntry* frames, int nFrames)
+        : pageReplacement(frames, nFrames), _queue(nFrames, 1) {}
+
+    const char* getName() { return "fifo"; }
+    void onFault(int frame, uint64_t now) { _queue.pushBack(0, frame); }
+    void onEvict(int frame) { _queue.remove(frame); }
+    int selectVictim(int pcb, int page, uint64_t now)
+    {
+        int nFrame = _queue.front(0);
+        while(!isCandidate(nFrame))
+            nFrame = _queue.next(nFrame);
+        return nFrame;
+    }
+};
+
+/***************************************************
+ * Second Chance - FIFO, but a referenced page has
+ * its bit cleared and goes to the back of the queue
+ * *************************************************/
+class secondChanceReplacement : public fifoReplacement
+{
+    public:
+
+    secondChanceReplacement(FrameTableEntry* frames, int nFrames)
+        : fifoReplacement(frames, nFrames) {}
+
+    const char* getName() { return "secondchance"; }
+
+    int selectVictim(int pcb, int page, uint64_t now)
+    {
+        int nFrame = _queue.front(0);
+        while(true)
+        {
+            int nNext = _queue.next(nFrame);
+            if(isCandidate(nFrame))
+            {
+                if(!_frames[nFrame].reference)
+                    return nFrame;
+                _frames[nFrame].reference = 0;
+                _queue.pushBack(0, nFrame);
+                if(nNext < 0)
+                    nNext = nFrame;
+            }
+            nFrame = nNext;
+        }
+    }
+};
+
+/***************************************************
+ * Clock - Second Chance with a hand sweeping the
+ * frame table in place instead of a queue
+ * *************************************************/
+class clockReplacement : public pageReplacement
+{
+    private:
+        int _hand;
+
+    public:
+
+    clockReplacement(FrameTableEntry* frames, int nFrames)
+        : pageReplacement(frames, nFrames), _hand(0) {}
+
+    const char* getName() { return "clock"; }
+    void onFault(int frame, uint64_t now) {}
+    void onEvict(int frame) {}
+
+    int selectVictim(int pcb, int page, uint64_t now)
+    {
+        while(true)
+        {
+            int nFrame = _hand;
+            // Maintain the circular reference
+            _hand = (_hand + 1) % _nFrames;
+            if(!isCandidate(nFrame))
+                continue;
+            if(!_frames[nFrame].reference)
+                return nFrame;
+            // Set the reference = 0, (2nd Chance Caching)
+            _frames[nFrame].reference = 0;
+        }
+    }
+};
+
+/***************************************************
+ * LRU - Exact least recently used.  TLB hits only
+ * stamp the frame table, so the victim is found by
+ * scanning for the oldest lastReference
+ * *************************************************/
+class lruReplacement : public pageReplacement
+{
+    public:
+
+    lruReplacement(FrameTableEntry* frames, int nFrames)
+        : pageReplacement(frames, nFrames) {}
+
+    const char* getName() { return "lru"; }
+    void onFault(int frame, uint64_t now) {}
+    void onEvict(int frame) {}
+
+    int selectVictim(int pcb, int page, uint64_t now)
+    {
+        int nVictim = -1;
+        for(int i = 0; i < _nFrames; i++)
+        {
+            if(isCandidate(i) && (nVictim < 0
+                || _frames[i].lastReference < _frames[nVictim].lastReference))
+                nVictim = i;
+        }
+        return nVictim;
+    }
+};
+
+/***************************************************
+ * Aging - Approximate LRU.  Each frame has a 32 bit
+ * age that is shifted right on every replacement,
+ * with the reference bit shifted in at the top.
+ * The smallest age is the victim
+ * *************************************************/
+class agingReplacement : public pageReplacement
+{
+    private:
+        vector<uint32_t> _age;
+
+    public:
+
+    agingReplacement(FrameTableEntry* frames, int nFrames)
+        : pageReplacement(frames, nFrames), _age(nFrames, 0) {}
+
+    const char* getName() { return "aging"; }
+    void onFault(int frame, uint64_t now) { _age[frame] = 0; }
+    void onEvict(int frame) { _age[frame] = 0; }
+
+    int selectVictim(int pcb, int page, uint64_t now)
+    {
+        int nVictim = -1;
+        for(int i = 0; i < _nFrames; i++)
+        {
+            _age[i] = (_age[i] >> 1) | (_frames[i].reference ? 0x80000000u : 0);
+            _frames[i].reference = 0;
+            if(isCandidate(i) && (nVictim < 0 || _age[i] < _age[nVictim]))
+                nVictim = i;
+        }
+        return nVictim;
+    }
+};
+
+/***************************************************
+ * LFU - Least frequently used since it was loaded.
+ * Ties go to the least recently used
+ * *************************************************/
+class lfuReplacement : public pageReplacement
+{
+    public:
+
+    lfuReplacement(FrameTableEntry* frames, int nFrames)
+        : pageReplacement(frames, nFrames) {}
+
+    const char* getName() { return "lfu"; }
+    void onFault(int frame, uint64_t now) {}
+    void onEvict(int frame) {}
+
+    int selectVictim(int pcb, int page, uint64_t now)
+    {
+        int nVictim = -1;
+        for(int i = 0; i < _nFrames; i++)
+        {
+            if(!isCandidate(i))
+                continue;
+            if(nVictim < 0 || _frames[i].referenceCount < _frames[nVictim].referenceCount
+                || (_frames[i].referenceCount == _frames[nVictim].referenceCount
+                    && _frames[i].lastReference < _frames[nVictim].lastReference))
+                nVictim = i;
+        }
+        return nVictim;
+    }
+};
+
+/***************************************************
+ * ARC - Adaptive Replacement Cache.  T1 holds pages
+ * seen once, T2 pages seen again, and the ghost lists
+ * B1/B2 remember what was evicted from each so the
+ * target size of T1 (p) adapts to the workload.
+ * Since TLB hits only set the reference bit, hits are
+ * applied lazily when a page reaches the LRU end of
+ * its list (the CAR formulation of ARC)
+ * *************************************************/
+class arcReplacement : public pageReplacement
+{
+    private:
+        enum { T1, T2 };
+        enum { B1, B2 };
+        frameLists _lists;
+        list<uint64_t> _ghost[2];
+        unordered_map<uint64_t, pair<int, list<uint64_t>::iterator> > _ghostIndex;
+        double _p;              // Target size of T1
+        uint64_t _adaptedKey;   // Page selectVictim already adapted p for
+
+        static uint64_t pageKey(int pcb, int page)
+        {
+            return ((uint64_t)(uint32_t)pcb << 32) | (uint32_t)page;
+        }
+
+        // Grow T1's target on a B1 ghost hit, shrink it on a B2 hit
+        void adapt(uint64_t nKey)
+        {
+            unordered_map<uint64_t, pair<int, list<uint64_t>::iterator> >::iterator it = _ghostIndex.find(nKey);
+            if(it == _ghostIndex.end())
+                return;
+            double b1 = _ghost[B1].size(), b2 = _ghost[B2].size();
+            if(it->second.first == B1)
+                _p = min((double)_nFrames, _p + max(1.0, b2 / b1));
+            else
+                _p = max(0.0, _p - max(1.0, b1 / b2));
+            _adaptedKey = nKey;
+        }
+
+        // Oldest page on a list that may be evicted, or -1
+        int firstCandidate(int nList)
+        {
+            int nFrame = _lists.front(nList);
+            while(nFrame > -1 && !isCandidate(nFrame))
+                nFrame = _lists.next(nFrame);
+            return nFrame;
+        }
+
+        void addGhost(int nGhost, uint64_t nKey)
+        {
+            _ghost[nGhost].push_back(nKey);
+            _ghostIndex[nKey] = make_pair(nGhost, --_ghost[nGhost].end());
+        }
+
+        void dropGhost(uint64_t nKey)
+        {
+            unordered_map<uint64_t, pair<int, list<uint64_t>::iterator> >::iterator it = _ghostIndex.find(nKey);
+            if(it == _ghostIndex.end())
+                return;
+            _ghost[it->second.first].erase(it->second.second);
+            _ghostIndex.erase(it);
+        }
+
+    public:
+
+    arcReplacement(FrameTableEntry* frames, int nFrames)
+        : pageReplacement(frames, nFrames), _lists(nFrames, 2), _p(0), _adaptedKey(~0ULL) {}
+
+    const char* getName() { return "arc"; }
+
+    void onAccess(int frame, bool isWrite, uint64_t now)
+    {
+        // Seen again - most recently used end of T2
+        _lists.pushBack(T2, frame);
+    }
+
+    void onFault(int frame, uint64_t now)
+    {
+        uint64_t nKey = pageKey(_frames[frame].pcb, _frames[frame].page);
+        if(_ghostIndex.count(nKey))
+        {
+            // Recently evicted - it has been seen before
+            if(nKey != _adaptedKey)
+                adapt(nKey);
+            dropGhost(nKey);
+            _lists.pushBack(T2, frame);
+        }
+        else
+            _lists.pushBack(T1, frame);
+        _adaptedKey = ~0ULL;
+
+        // Keep the directory to c pages in L1 and 2c in total
+        while(_lists.size(T1) + (int)_ghost[B1].size() > _nFrames && !_ghost[B1].empty())
+            dropGhost(_ghost[B1].front());
+        while(_lists.size(T1) + _lists.size(T2) + (int)(_ghost[B1].size() + _ghost[B2].size()) > 2 * _nFrames
+            && !_ghost[B2].empty())
+            dropGhost(_ghost[B2].front());
+    }
+
+    void onEvict(int frame)
+    {
+        // Victims are already moved to a ghost list; this only
+        // catches frames freed by a process exiting
+        _lists.remove(frame);
+    }
+
+    int selectVictim(int pcb, int page, uint64_t now)
+    {
+        uint64_t nKey = pageKey(pcb, page);
+        adapt(nKey);
+        unordered_map<uint64_t, pair<int, list<uint64_t>::iterator> >::iterator it = _ghostIndex.find(nKey);
+        bool inB2 = (it != _ghostIndex.end() && it->second.first == B2);
+
+        while(true)
+        {
+            bool bFromT1 = _lists.size(T1) > 0 && (_lists.size(T1) > _p
+                || (inB2 && _lists.size(T1) == (int)_p) || _lists.size(T2) == 0);
+            int nFrame = firstCandidate(bFromT1 ? T1 : T2);
+            if(nFrame < 0)
+            {
+                // None of the owner's pages are on that list
+                bFromT1 = !bFromT1;
+                nFrame = firstCandidate(bFromT1 ? T1 : T2);
+            }
+            if(_frames[nFrame].reference)
+            {
+                // Hit since it got here - promote it to T2
+                _frames[nFrame].reference = 0;
+                _lists.pushBack(T2, nFrame);
+                continue;
+            }
+            _lists.remove(nFrame);
+            addGhost(bFromT1 ? B1 : B2, pageKey(_frames[nFrame].pcb, _frames[nFrame].page));
+            return nFrame;
+        }
+    }
+};
+
+/***************************************************
+ * WSClock - Clock over the working set.  Referenced
+ * pages get their bit cleared, clean pages older
+ * than tau are evicted.  Old dirty pages are only
+ * taken if a whole sweep finds nothing clean
+ * *************************************************/
+class wsClockReplacement : public pageReplacement
+{
+    private:
+        int _hand;
+
+    public:
+
+    wsClockReplacement(FrameTableEntry* frames, int nFrames)
+        : pageReplacement(frames, nFrames), _hand(0) {}
+
+    const char* getName() { return "wsclock"; }
+    void onFault(int frame, uint64_t now) {}
+    void onEvict(int frame) {}
+
+    int selectVictim(int pcb, int page, uint64_t now)
+    {
+        int nDirtyVictim = -1;
+        for(int i = 0; i < _nFrames; i++)
+        {
+            int nFrame = _hand;
+            _hand = (_hand + 1) % _nFrames;
+            FrameTableEntry& fte = _frames[nFrame];
+            if(!isCandidate(nFrame))
+                continue;
+            if(fte.reference)
+            {
+                // In the working set - give it another pass
+                fte.reference = 0;
+                fte.lastReference = now;
+                continue;
+            }
+            // The age is unsigned - a page stamped at or after now
+            // is as young as it gets
+            if(fte.lastReference < now && now - fte.lastReference > wsClockTau)
+            {
+                if(!fte.dirty)
+                    return nFrame;
+                if(nDirtyVictim < 0)
+                    nDirtyVictim = nFrame;
+            }
+        }
+        if(nDirtyVictim > -1)
+            return nDirtyVictim;
+
+        // Everything is in the working set - take the oldest
+        int nVictim = -1;
+        for(int i = 0; i < _nFrames; i++)
+        {
+            if(isCandidate(i) && (nVictim < 0
+                || _frames[i].lastReference < _frames[nVictim].lastReference))
+                nVictim = i;
+        }
+        return nVictim;
+    }
+};
+
+// Returns the policy with this name, or NULL if there is none
+pageReplacement* CreatePageReplacement(std::string strName, FrameTableEntry* frames, int nFrames)
+{
+    if(strName == "fifo")
+        return new fifoReplacement(frames, nFrames);
+    if(strName == "secondchance")
+        return new secondChanceReplacement(frames, nFrames);
+    if(strName == "clock")
+        return new clockReplacement(frames, nFrames);
+    if(strName == "lru")
+        return new lruReplacement(frames, nFrames);
+    if(strName == "aging")
+        return new agingReplacement(frames, nFrames);
+    if(strName == "lfu")
+        return new lfuReplacement(frames, nFrames);
+    if(strName == "arc")
+        return new arcReplacement(frames, nFrames);
+    if(strName == "wsclock")
+        return new wsClockReplacement(frames, nFrames);
+    return NULL;
+}
+
+bool IsPageReplacementName(std::string strName)
+{
+    return strName == "fifo" || strName == "secondchance" || strName == "clock"
+        || strName == "lru" || strName == "aging" || strName == "lfu"
+        || strName == "arc" || strName == "wsclock";
+}
+
+std::string GetPageReplacementNames()
+{
+    return "fifo, secondchance, clock, lru, aging, lfu, arc, wsclock";
+}
+
+std::vector<std::string> GetPageReplacementNameList()
+{
+    return { "fifo", "secondchance", "clock", "lru", "aging", "lfu", "arc", "wsclock" };
+}
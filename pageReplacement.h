@@ -0,0 +1,77 @@
+/********************************************
+ * pageReplacement - Page Replacement Policies
+ * Interface for the page replacement policies
+ * oss can run with, plus the implementations:
+ * FIFO, Second Chance, Clock, LRU, Aging, LFU,
+ * ARC and WSClock.  Pick one with
+ * CreatePageReplacement.  A victim can be
+ * limited to one process' pages, for local
+ * frame allocation.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * pageReplacement .h file for project
+ ********************************************/
+#ifndef PAGEREPLACEMENT_H
+#define PAGEREPLACEMENT_H
+
+#include <string>
+#include <vector>
+#include "frameTable.h"
+
+class pageReplacement
+{
+    protected:
+        FrameTableEntry* _frames;
+        int _nFrames;
+        int _nVictimOwner;      // Only this PCB's pages can be picked, -1 for any
+
+        // Can frame be the victim
+        bool isCandidate(int frame)
+        {
+            return _nVictimOwner < 0 || _frames[frame].pcb == _nVictimOwner;
+        }
+
+    public:
+
+    pageReplacement(FrameTableEntry* frames, int nFrames)
+        : _frames(frames), _nFrames(nFrames), _nVictimOwner(-1) {}
+    virtual ~pageReplacement() {}
+
+    // Name used on the command line
+    virtual const char* getName() = 0;
+
+    // A resident page was accessed through oss.  TLB hits never
+    // reach oss - they only update the frame table entry
+    virtual void onAccess(int frame, bool isWrite, uint64_t now) {}
+
+    // A faulting page was loaded into frame.  The frame table entry
+    // is already filled in
+    virtual void onFault(int frame, uint64_t now) = 0;
+
+    // The page in frame is leaving memory - evicted, or its process
+    // exited.  Called before the frame table entry is cleared
+    virtual void onEvict(int frame) = 0;
+
+    // Pick the frame to evict to make room for pcb/page.  Only
+    // called when every frame is in use
+    virtual int selectVictim(int pcb, int page, uint64_t now) = 0;
+
+    // Limit selectVictim to the pages of one PCB, which must hold
+    // at least one frame.  -1 lifts the limit
+    void setVictimOwner(int pcb) { _nVictimOwner = pcb; }
+};
+
+// Returns the policy with this name, or NULL if there is none
+pageReplacement* CreatePageReplacement(std::string, FrameTableEntry*, int);
+
+// Checks a name given on the command line
+bool IsPageReplacementName(std::string);
+
+// Names of all the policies, for usage messages
+std::string GetPageReplacementNames();
+
+// The same names as a list
+std::vector<std::string> GetPageReplacementNameList();
+
+#endif // PAGEREPLACEMENT_H
@@ -0,0 +1,193 @@
+/********************************************
+ * pageTable - Memory geometry and page tables
+ * The sizes of the simulated memory, set at
+ * run time, the page table entry and the PCB
+ * that holds a process' page table.  Kept apart from sharedStructures.h
+ * so the pager and the trace tools can be built
+ * on their own.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * pageTable .h file for project
+ ********************************************/
+#ifndef PAGETABLE_H
+#define PAGETABLE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <sys/types.h>
+
+//***************************************************
+// Memory Geometry
+//***************************************************
+// Set at run time by SetMemoryGeometry and SetProcessCount - these
+// are the defaults.  Every process sets the same values: oss from
+// its options, user_proc from the shared segment
+inline int processesMax = 20;       // PCB slots, and their message and log channels
+inline int totalMemory = 256;       // Physical frames
+inline int pageCount = 32;          // Pages per process
+inline int pageSize = 1024;
+inline int frameSize = 1024;
+inline int processSize = 32768;     // Bytes of virtual address space per process
+// Address translation - pageSize must be a power of 2 so that a
+// virtual address splits into page number and offset with a shift/mask
+inline int pageShift = 10;
+inline int pageOffsetMask = 1023;
+
+// Largest geometry - virtual and physical addresses have to fit in
+// the 32-bit addresses the messages carry
+const int pageSizeMin = 16;
+const int pageSizeMax = 1 << 20;
+const uint64_t addressSpaceMax = 1ULL << 32;
+// Most PCB slots.  Each one has its own log ring, 64K of the
+// shared segment, and under oss its own user_proc and pidfd
+const int processesLimit = 4096;
+
+// Sets the geometry.  Returns false, and changes nothing, if it
+// can't be used
+inline bool SetMemoryGeometry(int nFrames, int nPages, int nPageSize)
+{
+    if(nFrames < 1 || nPages < 1 || nPageSize < pageSizeMin || nPageSize > pageSizeMax
+        || (nPageSize & (nPageSize - 1)) != 0
+        || (uint64_t)nPages * nPageSize >= addressSpaceMax / 2    // processSize is an int
+        || (uint64_t)nFrames * nPageSize > addressSpaceMax
+        || nFrames >= (1 << 28) - 1)      // A PTE holds 28 bits of frame number
+        return false;
+    totalMemory = nFrames;
+    pageCount = nPages;
+    pageSize = nPageSize;
+    frameSize = nPageSize;
+    processSize = nPages * nPageSize;
+    pageShift = __builtin_ctz(nPageSize);
+    pageOffsetMask = nPageSize - 1;
+    return true;
+}
+
+// Sets the number of PCB slots.  Returns false, and changes
+// nothing, if it can't be used
+inline bool SetProcessCount(int nProcesses)
+{
+    if(nProcesses < 1 || nProcesses > processesLimit)
+        return false;
+    processesMax = nProcesses;
+    return true;
+}
+
+// An array kept as an offset from this object rather than a
+// pointer, so it reads the same in every process that has the
+// shared segment mapped, wherever the segment lands
+template <typename T>
+struct relativeArray
+{
+    int64_t offset;
+
+    void set(T* array) { offset = (char*)array - (char*)this; }
+    T* get() const { return (T*)((char*)this + offset); }
+    T& operator[](size_t i) const { return get()[i]; }
+};
+
+// Size of a cache line.  Data written by different processes is
+// kept on different lines so they don't fight over them
+const int cacheLineSize = 64;
+
+// Credit to Jared Diehl for his breakdown of these items
+// Each PCB's ptable is indexed directly by virtual page number.
+// A PTE is one 32-bit word - the frame number in the low bits and
+// the flags above it.  user_proc sets the reference bit while oss
+// changes the rest, so every change is an atomic operation on the
+// whole word
+const uint32_t pteFrameBits = 28;
+const uint32_t pteFrameMask = (1u << pteFrameBits) - 1;   // All ones is no frame
+const uint32_t pteReference = 1u << 28;     // second chance page replacement reference bit
+const uint32_t pteProtection = 1u << 29;    // page is read=0 or write=1 (may not be needed)
+const uint32_t pteDirty = 1u << 30;         // page has been modified
+const uint32_t pteValid = 1u << 31;         // this PTE is loaded with a page
+
+struct PageTable {
+    std::atomic<uint32_t> bits;
+
+    // frame index this page is loaded in, -1 if none
+    int getFrame() const
+    {
+        uint32_t nFrame = bits.load(std::memory_order_relaxed) & pteFrameMask;
+        return nFrame == pteFrameMask ? -1 : (int)nFrame;
+    }
+    bool isReferenced() const { return bits.load(std::memory_order_relaxed) & pteReference; }
+    bool getProtection() const { return bits.load(std::memory_order_relaxed) & pteProtection; }
+    bool isDirty() const { return bits.load(std::memory_order_relaxed) & pteDirty; }
+    bool isValid() const { return bits.load(std::memory_order_relaxed) & pteValid; }
+
+    void setFlag(uint32_t nFlag, bool bSet)
+    {
+        if(bSet)
+            bits.fetch_or(nFlag, std::memory_order_relaxed);
+        else
+            bits.fetch_and(~nFlag, std::memory_order_relaxed);
+    }
+    void setReferenced(bool bSet) { setFlag(pteReference, bSet); }
+    void setProtection(bool bSet) { setFlag(pteProtection, bSet); }
+    void setDirty(bool bSet) { setFlag(pteDirty, bSet); }
+    void setValid(bool bSet) { setFlag(pteValid, bSet); }
+    // Clears the reference bit, returning whether it was set
+    bool takeReferenced()
+    {
+        return bits.fetch_and(~pteReference, std::memory_order_relaxed) & pteReference;
+    }
+
+    // Replaces the whole entry at once
+    void set(int nFrame, bool bReference, bool bProtection, bool bDirty, bool bValid)
+    {
+        bits.store(((uint32_t)nFrame & pteFrameMask)
+            | (bReference ? pteReference : 0) | (bProtection ? pteProtection : 0)
+            | (bDirty ? pteDirty : 0) | (bValid ? pteValid : 0), std::memory_order_relaxed);
+    }
+};
+static_assert(sizeof(PageTable) == 4, "A PTE must pack into 32 bits");
+
+// Each PCB starts on its own cache line.  The TLB counters, which
+// user_proc writes on every reference, get a line to themselves.
+// The page table itself is laid out after all the PCBs
+struct alignas(cacheLineSize) PCB {
+	pid_t pid;
+	std::atomic<uint> tlbGeneration; // Bumped by oss when it unmaps one of this PCB's pages
+	relativeArray<PageTable> ptable; // pageCount pages
+	alignas(cacheLineSize) uint64_t tlbHits;    // TLB counters - written by user_proc,
+	uint64_t tlbMisses;             // totaled by oss when the process exits
+};
+
+// Points each of nPcbs PCBs at its page table in ptables, which
+// must hold nPcbs * pageCount entries
+inline void LinkPageTables(PCB* pcbs, int nPcbs, PageTable* ptables)
+{
+    for(int i = 0; i < nPcbs; i++)
+        pcbs[i].ptable.set(ptables + (size_t)i * pageCount);
+}
+
+// PCBs with their page tables, for the tools that run the pager
+// on their own memory.  Free them with DeletePcbs
+inline PCB* NewPcbs(int nPcbs)
+{
+    PCB* pcbs = new PCB[nPcbs];
+    LinkPageTables(pcbs, nPcbs, new PageTable[(size_t)nPcbs * pageCount]);
+    return pcbs;
+}
+
+inline void DeletePcbs(PCB* pcbs)
+{
+    delete [] pcbs[0].ptable.get();
+    delete [] pcbs;
+}
+
+// Splits a virtual address into page number and offset
+inline uint GetPageNumber(const uint address) { return address >> pageShift; }
+inline uint GetPageOffset(const uint address) { return address & pageOffsetMask; }
+
+// Builds a physical address from frame and offset, and splits it
+// again.  Physical memory can reach 2^32 bytes, so this is unsigned
+inline uint GetPhysicalAddress(const uint frame, const uint offset)
+{
+    return (frame << pageShift) | offset;
+}
+inline uint GetFrameNumber(const uint address) { return address >> pageShift; }
+
+#endif // PAGETABLE_H
@@ -0,0 +1,258 @@
+/********************************************
+ * pager - Page tables, frames and replacement
+ * Resolves memory references against the
+ * process page tables, hands out physical
+ * frames and evicts through the replacement
+ * policy when memory is full.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * pager .cpp file for project
+ ********************************************/
+
+#include <stdlib.h>
+#include "pager.h"
+
+using namespace std;
+
+pager::pager(PCB* pcbs, int nPcbs, FrameTableEntry* frames, int nFrames,
+    pageReplacement* replacement)
+    : _pcbs(pcbs), _nPcbs(nPcbs), _frames(frames), _nFrames(nFrames),
+      _replacement(replacement), _memory(nFrames), _dirty(nFrames), _nFreeHint(0),
+      _nEvictions(0), _nWritebacks(0), _prefetcher(NULL), _nPrefetches(0),
+      _allocator(NULL), _resident(nPcbs, 0), _nLocalEvictions(0), _bTlbReferences(false)
+{
+    // Every physical frame starts out free
+    for(int i = 0; i < nFrames; i++)
+    {
+        _frames[i].pcb = -1;
+        _frames[i].page = -1;
+        _frames[i].dirty = 0;
+        _frames[i].reference = 0;
+        _frames[i].referenceCount = 0;
+        _frames[i].lastReference = 0;
+        _frames[i].prefetched = 0;
+    }
+    for(int i = 0; i < nPcbs; i++)
+        for(int j = 0; j < pageCount; j++)
+            _pcbs[i].ptable[j].set(-1, false, false, false, false);
+}
+
+void pager::resetProcess(int nPcb)
+{
+    PCB& pcb = _pcbs[nPcb];
+    for(int j = 0; j < pageCount; j++)
+    {
+        if(pcb.ptable[j].isValid())
+            releaseFrame(pcb.ptable[j].getFrame());
+        pcb.ptable[j].set(-1, false, rand() % 2, false, false);
+    }
+    pcb.tlbGeneration++;
+}
+
+PagerResult pager::access(int nPcb, uint address, bool isWrite, uint64_t now, int& frame)
+{
+    if(nPcb < 0 || nPcb >= _nPcbs || address >= (uint)processSize)
+        return PAGE_SEGFAULT;
+
+    // The page number indexes directly into the process' page
+    // table - O(1) no matter how many pages a process has
+    PageTable& pte = _pcbs[nPcb].ptable[GetPageNumber(address)];
+    if(!pte.isValid())
+        return PAGE_FAULT;
+
+    const int nFrame = pte.getFrame();
+    FrameTableEntry& fte = _frames[nFrame];
+    if(fte.prefetched)
+    {
+        // Read-ahead paid off - this would have been a fault
+        fte.prefetched = 0;
+        if(_prefetcher != NULL)
+            _prefetcher->onUsed(nPcb);
+    }
+    fte.reference = 1;
+    fte.referenceCount++;
+    fte.lastReference = now;
+    if(isWrite)
+    {
+        pte.setDirty(true);
+        fte.dirty = 1;
+        _dirty.set(nFrame);
+    }
+    _replacement->onAccess(nFrame, isWrite, now);
+    frame = nFrame;
+    return PAGE_HIT;
+}
+
+int pager::loadPage(int nPcb, int nPage, bool isWrite, uint64_t now, bool& wroteBack,
+    PagerEviction* evicted)
+{
+    int nFrame = takeFrame(nPcb, nPage, now, wroteBack, evicted);
+
+    // Set the Page and Frame data
+    _pcbs[nPcb].ptable[nPage].set(nFrame, false, rand() % 2, isWrite, true);
+    _frames[nFrame].pcb = nPcb;
+    _frames[nFrame].page = nPage;
+    _frames[nFrame].reference = 1;
+    _frames[nFrame].dirty = isWrite;
+    if(isWrite)
+        _dirty.set(nFrame);
+    _frames[nFrame].referenceCount = 1;
+    _frames[nFrame].lastReference = now;
+    _frames[nFrame].prefetched = 0;
+    _replacement->onFault(nFrame, now);
+    return nFrame;
+}
+
+int pager::prefetchPage(int nPcb, int nPage, uint64_t now, bool& wroteBack,
+    PagerEviction* evicted)
+{
+    wroteBack = false;
+    if(evicted != NULL)
+        evicted->frame = -1;
+    if(nPcb < 0 || nPcb >= _nPcbs || nPage < 0 || nPage >= pageCount
+        || _pcbs[nPcb].ptable[nPage].isValid())
+        return -1;
+    int nFrame = takeFrame(nPcb, nPage, now, wroteBack, evicted);
+
+    // Not referenced yet, so the policies see it as the cold page
+    // it is until it gets used
+    _pcbs[nPcb].ptable[nPage].set(nFrame, false, rand() % 2, false, true);
+    _frames[nFrame].pcb = nPcb;
+    _frames[nFrame].page = nPage;
+    _frames[nFrame].reference = 0;
+    _frames[nFrame].dirty = 0;
+    _frames[nFrame].referenceCount = 0;
+    _frames[nFrame].lastReference = now;
+    _frames[nFrame].prefetched = 1;
+    _replacement->onFault(nFrame, now);
+    _nPrefetches++;
+    return nFrame;
+}
+
+// takeFrame - get a physical frame for pcb's page. If none are free,
+// the replacement policy picks a victim from the global frame table
+// and it is returned to the free list first.  With an allocator, a
+// process at its quota replaces one of its own pages, and one under
+// it takes from the process furthest over
+int pager::takeFrame(int nPcb, int nPage, uint64_t now, bool& wroteBack,
+    PagerEviction* evicted)
+{
+    wroteBack = false;
+    if(evicted != NULL)
+        evicted->frame = -1;
+
+    int nOwner = -1;
+    if(_allocator != NULL && _allocator->isEnabled()
+        && _allocator->atQuota(nPcb, _resident[nPcb]))
+        nOwner = nPcb;
+    int nFrame = nOwner < 0 ? allocateFrame() : -1;
+    if(nFrame < 0)
+    {
+        if(nOwner == nPcb)
+            _nLocalEvictions++;
+        else if(_allocator != NULL && _allocator->isEnabled())
+            nOwner = _allocator->findDonor();
+        collectReferences(now);
+        _replacement->setVictimOwner(nOwner);
+        int nVictimFrame = _replacement->selectVictim(nPcb, nPage, now);
+        _replacement->setVictimOwner(-1);
+        _nEvictions++;
+        FrameTableEntry& victim = _frames[nVictimFrame];
+        PageTable& victimPte = _pcbs[victim.pcb].ptable[victim.page];
+
+        // A dirty victim has to be written out first
+        if(victim.dirty)
+        {
+            wroteBack = true;
+            _nWritebacks++;
+        }
+        if(evicted != NULL)
+        {
+            evicted->frame = nVictimFrame;
+            evicted->pcb = victim.pcb;
+            evicted->page = victim.page;
+            evicted->dirty = victim.dirty;
+        }
+        // Unmap it, unless the page was already dropped
+        // and remapped elsewhere
+        if(victimPte.isValid() && victimPte.getFrame() == nVictimFrame)
+        {
+            victimPte.set(nVictimFrame, false, victimPte.getProtection(), false, false);
+            // Invalidate the owner's TLB
+            _pcbs[victim.pcb].tlbGeneration++;
+        }
+        releaseFrame(nVictimFrame);
+        nFrame = allocateFrame();
+    }
+    _resident[nPcb]++;
+    if(_allocator != NULL)
+        _allocator->setResident(nPcb, _resident[nPcb]);
+    return nFrame;
+}
+
+void pager::collectReferences(uint64_t now)
+{
+    if(!_bTlbReferences)
+        return;
+    for(int nFrame = _memory.findFirstSet(); nFrame >= 0; nFrame = _memory.findFirstSet(nFrame + 1))
+    {
+        FrameTableEntry& fte = _frames[nFrame];
+        if(fte.pcb < 0 || !_pcbs[fte.pcb].ptable[fte.page].takeReferenced())
+            continue;
+        fte.reference = 1;
+        fte.referenceCount++;
+        fte.lastReference = now;
+    }
+}
+
+bool pager::cleanPage(int nFrame, int nPcb, int nPage)
+{
+    FrameTableEntry& fte = _frames[nFrame];
+    if(!_dirty.test(nFrame) || fte.pcb != nPcb || fte.page != nPage)
+        return false;
+    PageTable& pte = _pcbs[nPcb].ptable[nPage];
+    fte.dirty = 0;
+    pte.setDirty(false);
+    _dirty.reset(nFrame);
+    _pcbs[nPcb].tlbGeneration++;
+    return true;
+}
+
+// allocateFrame - take the lowest free frame from the memory map.
+// The search starts at the hint, so it skips the full words below
+// it.  Returns -1 if all physical frames are in use
+int pager::allocateFrame()
+{
+    int nFrame = _memory.findFirstClear(_nFreeHint);
+    if(nFrame < 0)
+        return -1;
+    _memory.set(nFrame);
+    _nFreeHint = nFrame + 1;
+    return nFrame;
+}
+
+// releaseFrame - return a frame to the memory map and clear its entry
+void pager::releaseFrame(int nFrame)
+{
+    if(nFrame < 0 || nFrame >= _nFrames || !_memory.getBitmapBits(nFrame))
+        return;
+    _replacement->onEvict(nFrame);
+    if(_frames[nFrame].prefetched && _prefetcher != NULL)
+        _prefetcher->onWasted(_frames[nFrame].pcb);
+    _frames[nFrame].prefetched = 0;
+    if(_frames[nFrame].pcb > -1)
+    {
+        _resident[_frames[nFrame].pcb]--;
+        if(_allocator != NULL)
+            _allocator->setResident(_frames[nFrame].pcb, _resident[_frames[nFrame].pcb]);
+    }
+    _frames[nFrame].pcb = -1;
+    _frames[nFrame].page = -1;
+    _frames[nFrame].dirty = 0;
+    _frames[nFrame].reference = 0;
+    _frames[nFrame].referenceCount = 0;
+    _dirty.reset(nFrame);
+    _memory.reset(nFrame);
+    _nFreeHint = min(_nFreeHint, nFrame);
+}
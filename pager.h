@@ -0,0 +1,120 @@
+/********************************************
+ * pager - Page tables, frames and replacement
+ * Resolves memory references against the
+ * process page tables, hands out physical
+ * frames and evicts through the replacement
+ * policy when memory is full.  oss drives it
+ * from process requests and the trace replay
+ * drives it from a recorded trace.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * pager .h file for project
+ ********************************************/
+#ifndef PAGER_H
+#define PAGER_H
+
+#include <string>
+#include <vector>
+#include "pageTable.h"
+#include "frameTable.h"
+#include "pageReplacement.h"
+#include "bitmapper.h"
+#include "prefetcher.h"
+#include "frameAllocator.h"
+
+// Outcome of a memory reference
+enum PagerResult { PAGE_HIT, PAGE_FAULT, PAGE_SEGFAULT };
+
+// The page loadPage evicted, if it had to
+struct PagerEviction {
+    int frame;          // -1 if nothing was evicted
+    int pcb;
+    int page;
+    bool dirty;
+};
+
+class pager
+{
+    private:
+        PCB* _pcbs;
+        int _nPcbs;
+        FrameTableEntry* _frames;
+        int _nFrames;
+        pageReplacement* _replacement;
+        bitmapper _memory;              // Frames in use - the frame allocator
+        bitmapper _dirty;               // Frames holding a modified page
+        int _nFreeHint;                 // No frame below this is free
+        long _nEvictions;
+        long _nWritebacks;
+        prefetcher* _prefetcher;        // Told when read-ahead is used or wasted
+        long _nPrefetches;
+        frameAllocator* _allocator;     // Per process quotas, NULL for global
+        std::vector<int> _resident;     // Frames each PCB holds
+        long _nLocalEvictions;          // Victims taken from the faulting process
+        bool _bTlbReferences;           // TLB hits set PTE reference bits to fold in
+
+        int takeFrame(int pcb, int page, uint64_t now, bool& wroteBack,
+            PagerEviction* evicted);
+        int allocateFrame();
+        void releaseFrame(int);
+
+    public:
+
+    pager(PCB* pcbs, int nPcbs, FrameTableEntry* frames, int nFrames,
+        pageReplacement* replacement);
+
+    // Clear a process' page table and free its frames
+    void resetProcess(int);
+
+    // Resolve a reference by pcb to a virtual address.  On a hit the
+    // reference state is updated and frame is set
+    PagerResult access(int pcb, uint address, bool isWrite, uint64_t now, int& frame);
+
+    // Load a faulted page, evicting a victim if memory is full.
+    // Returns the frame; wroteBack is set if the victim was dirty.
+    // The victim is described in evicted, if given
+    int loadPage(int pcb, int page, bool isWrite, uint64_t now, bool& wroteBack,
+        PagerEviction* evicted = NULL);
+
+    // Read a page ahead of use, evicting like loadPage does.  It is
+    // mapped but marked prefetched until first accessed.  Returns the
+    // frame, or -1 if the page is already resident
+    int prefetchPage(int pcb, int page, uint64_t now, bool& wroteBack,
+        PagerEviction* evicted = NULL);
+    void setPrefetcher(prefetcher* readAhead) { _prefetcher = readAhead; }
+    long getPrefetches() { return _nPrefetches; }
+
+    // Victims come from the faulting process once it is at its
+    // quota, or from whoever is furthest over theirs
+    void setAllocator(frameAllocator* allocator) { _allocator = allocator; }
+    int getResident(int pcb) { return _resident[pcb]; }
+    long getLocalEvictions() { return _nLocalEvictions; }
+
+    // user_proc resolves TLB hits itself and only sets the PTE
+    // reference bit.  collectReferences counts those hits in the
+    // frame table as made at now, and clears the bits.  Victims
+    // are only picked after it has run
+    void setTlbReferences(bool bEnabled) { _bTlbReferences = bEnabled; }
+    void collectReferences(uint64_t now);
+
+    // Marks the page in frame clean once the page cleaner starts
+    // writing it out, and flushes the owner's TLB so its next write
+    // comes back through oss to dirty it again.  Returns false if
+    // the frame no longer holds that dirty page
+    bool cleanPage(int frame, int pcb, int page);
+
+    // First dirty frame at or after nStart, or -1
+    int findDirtyFrame(int nStart) { return _dirty.findFirstSet(nStart); }
+    int dirtyFrames() { return _dirty.count(); }
+    int getFrameCount() { return _nFrames; }
+    const FrameTableEntry& getFrameEntry(int frame) { return _frames[frame]; }
+
+    int framesInUse() { return _memory.count(); }
+    long getEvictions() { return _nEvictions; }
+    long getWritebacks() { return _nWritebacks; }
+    bitmapper& getMemoryMap() { return _memory; }
+    pageReplacement* getReplacement() { return _replacement; }
+};
+
+#endif // PAGER_H
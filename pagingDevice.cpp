@@ -0,0 +1,373 @@
+/********************************************
+ * pagingDevice - Paging devices and I/O scheduling
+ * The swap devices oss queues page faults on,
+ * their seek/transfer timing and the I/O
+ * schedulers that order each device's queue.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * pagingDevice .cpp file for project
+ ********************************************/
+
+#include <stdlib.h>
+#include "pageTable.h"
+#include "pagingDevice.h"
+
+using namespace std;
+
+/***************************************************
+ * FIFO - Serve requests in arrival order, like
+ * the original single IOQueue
+ * *************************************************/
+class fifoScheduler : public ioScheduler
+{
+    public:
+
+    const char* getName() { return "fifo"; }
+
+    int select(const deque<MemQueueItems>& queue, int64_t headTrack, uint64_t now)
+    {
+        return 0;
+    }
+};
+
+/***************************************************
+ * SSTF - Shortest seek time first.  Serve the
+ * request closest to the head.  Ties go to the
+ * oldest
+ * *************************************************/
+class sstfScheduler : public ioScheduler
+{
+    public:
+
+    const char* getName() { return "sstf"; }
+
+    int select(const deque<MemQueueItems>& queue, int64_t headTrack, uint64_t now)
+    {
+        int nBest = 0;
+        for(int i = 1; i < (int)queue.size(); i++)
+            if(abs(queue[i].track - headTrack) < abs(queue[nBest].track - headTrack))
+                nBest = i;
+        return nBest;
+    }
+};
+
+/***************************************************
+ * SCAN - Elevator.  The head sweeps one way
+ * serving the closest request ahead of it, and
+ * turns around when there is nothing left ahead
+ * *************************************************/
+class scanScheduler : public ioScheduler
+{
+    private:
+        bool _bUp = true;
+
+        int closestAhead(const deque<MemQueueItems>& queue, int64_t headTrack)
+        {
+            int nBest = -1;
+            for(int i = 0; i < (int)queue.size(); i++)
+            {
+                int64_t nDistance = _bUp ? queue[i].track - headTrack : headTrack - queue[i].track;
+                if(nDistance >= 0 && (nBest < 0
+                    || nDistance < abs(queue[nBest].track - headTrack)))
+                    nBest = i;
+            }
+            return nBest;
+        }
+
+    public:
+
+    const char* getName() { return "scan"; }
+
+    int select(const deque<MemQueueItems>& queue, int64_t headTrack, uint64_t now)
+    {
+        int nBest = closestAhead(queue, headTrack);
+        if(nBest < 0)
+        {
+            _bUp = !_bUp;
+            nBest = closestAhead(queue, headTrack);
+        }
+        return nBest;
+    }
+};
+
+/***************************************************
+ * Deadline - SCAN order, except a request that
+ * has waited past its deadline is served first,
+ * so no fault starves behind a busy region of
+ * the disk
+ * *************************************************/
+class deadlineScheduler : public scanScheduler
+{
+    public:
+
+    const char* getName() { return "deadline"; }
+
+    int select(const deque<MemQueueItems>& queue, int64_t headTrack, uint64_t now)
+    {
+        // The queue is in arrival order, so the front has the
+        // earliest deadline
+        if(queue.front().deadline <= now)
+            return 0;
+        return scanScheduler::select(queue, headTrack, now);
+    }
+};
+
+ioScheduler* CreateIOScheduler(std::string strName)
+{
+    if(strName == "fifo")
+        return new fifoScheduler();
+    if(strName == "sstf")
+        return new sstfScheduler();
+    if(strName == "scan")
+        return new scanScheduler();
+    if(strName == "deadline")
+        return new deadlineScheduler();
+    return NULL;
+}
+
+bool IsIOSchedulerName(std::string strName)
+{
+    return strName == "fifo" || strName == "sstf" || strName == "scan"
+        || strName == "deadline";
+}
+
+std::string GetIOSchedulerNames()
+{
+    return "fifo, sstf, scan, deadline";
+}
+
+/***************************************************
+ * pagingDevices
+ * *************************************************/
+pagingDevices::pagingDevices(int nDevices, std::string strScheduler)
+    : _devices(max(1, min(nDevices, pagingDevicesMax))), _nInFlight(0)
+{
+    for(pagingDevice& device : _devices)
+    {
+        device.scheduler = CreateIOScheduler(strScheduler);
+        device.busy = false;
+        device.busyUntil = 0;
+        device.headTrack = 0;
+        device.lastBlock = -1;
+        device.stats = PagingDeviceStats();
+    }
+}
+
+pagingDevices::~pagingDevices()
+{
+    for(pagingDevice& device : _devices)
+        delete device.scheduler;
+}
+
+// Every page of every process has its own swap block.  Blocks
+// are striped over the devices so neighbouring pages can be
+// read in parallel.  Thousands of processes with large page
+// counts need more than 2^31 blocks
+int64_t pagingDevices::getBlock(int pcb, int page)
+{
+    return (int64_t)pcb * pageCount + page;
+}
+
+// Device a swap block is striped onto
+int pagingDevices::getDevice(int64_t nBlock)
+{
+    return (int)((nBlock / deviceStripeBlocks) % (int64_t)_devices.size());
+}
+
+// Where the block is on its device
+int64_t pagingDevices::getDeviceBlock(int64_t nBlock)
+{
+    return (nBlock / deviceStripeBlocks / (int64_t)_devices.size()) * deviceStripeBlocks
+        + nBlock % deviceStripeBlocks;
+}
+
+// Seek time to move the head to track - nothing if it is there
+uint64_t pagingDevices::moveHead(pagingDevice& device, int64_t track)
+{
+    int64_t nDistance = abs(track - device.headTrack);
+    device.headTrack = track;
+    device.stats.seekTracks += nDistance;
+    if(nDistance == 0)
+        return 0;
+    return deviceSettleNS + deviceTrackSeekNS * nDistance;
+}
+
+// transferBlock - time to read or write one block.  If it is the
+// block right after the one just read, on the same track, it is
+// already coming up under the head
+uint64_t pagingDevices::transferBlock(pagingDevice& device, int64_t nBlock)
+{
+    int64_t nDeviceBlock = getDeviceBlock(nBlock);
+    int64_t nTrack = nDeviceBlock / deviceBlocksPerTrack;
+    bool bNext = nDeviceBlock == device.lastBlock + 1 && nTrack == device.headTrack;
+    device.lastBlock = nDeviceBlock;
+    if(bNext)
+        return deviceTransferNS;
+    return moveHead(device, nTrack) + deviceRotationNS + deviceTransferNS;
+}
+
+void pagingDevices::submit(MemQueueItems item, uint64_t now)
+{
+    int64_t nBlock = getBlock(item.pcb, item.page);
+    pagingDevice& device = _devices[getDevice(nBlock)];
+    item.track = getDeviceBlock(nBlock) / deviceBlocksPerTrack;
+    item.queuedTime = now;
+    item.deadline = now + deviceDeadlineNS;
+    device.queue.push_back(item);
+    device.stats.nMaxQueue = max(device.stats.nMaxQueue, (long)device.queue.size());
+}
+
+bool pagingDevices::submitBackground(MemQueueItems item, uint64_t now)
+{
+    int64_t nBlock = getBlock(item.pcb, item.page);
+    pagingDevice& device = _devices[getDevice(nBlock)];
+    if(!device.background.empty() || (device.busy && device.current.isCleaning))
+        return false;
+    item.track = getDeviceBlock(nBlock) / deviceBlocksPerTrack;
+    item.queuedTime = now;
+    item.deadline = now + deviceDeadlineNS;
+    device.background.push_back(item);
+    return true;
+}
+
+int pagingDevices::startNext(uint64_t now, MemQueueItems& item)
+{
+    for(int i = 0; i < (int)_devices.size(); i++)
+    {
+        pagingDevice& device = _devices[i];
+        if(device.busy || (device.queue.empty() && device.background.empty()))
+            continue;
+
+        if(device.queue.empty())
+        {
+            // Nothing is waiting on the device - clean a page
+            device.current = device.background.front();
+            device.background.pop_front();
+        }
+        else
+        {
+            int nNext = device.scheduler->select(device.queue, device.headTrack, now);
+            device.current = device.queue[nNext];
+            device.queue.erase(device.queue.begin() + nNext);
+            device.stats.waitNS += now - device.current.queuedTime;
+        }
+        device.busy = true;
+        device.busyUntil = now;
+        _nInFlight++;
+        item = device.current;
+        return i;
+    }
+    return -1;
+}
+
+uint64_t pagingDevices::beginService(int nDevice, uint64_t now, bool writeBack,
+    int victimPcb, int victimPage)
+{
+    pagingDevice& device = _devices[nDevice];
+    uint64_t nServiceNS = 0;
+    if(writeBack)
+    {
+        // The device serving the fault writes the victim out to
+        // the victim's slot on this device
+        int64_t nTrack = getDeviceBlock(getBlock(victimPcb, victimPage)) / deviceBlocksPerTrack;
+        nServiceNS += moveHead(device, nTrack) + deviceRotationNS + deviceTransferNS;
+        device.lastBlock = -1;
+        device.stats.nWritebacks++;
+    }
+    nServiceNS += moveHead(device, device.current.track) + deviceRotationNS + deviceTransferNS;
+    device.lastBlock = getDeviceBlock(getBlock(device.current.pcb, device.current.page));
+
+    device.busyUntil = now + nServiceNS;
+    device.stats.serviceNS += nServiceNS;
+    return nServiceNS;
+}
+
+uint64_t pagingDevices::beginCleaning(int nDevice, uint64_t now, bool write)
+{
+    pagingDevice& device = _devices[nDevice];
+    uint64_t nServiceNS = 0;
+    if(write)
+    {
+        nServiceNS = transferBlock(device, getBlock(device.current.pcb, device.current.page));
+        device.stats.nCleaned++;
+    }
+    device.busyUntil = now + nServiceNS;
+    device.stats.serviceNS += nServiceNS;
+    return nServiceNS;
+}
+
+bool pagingDevices::isOnDevice(int nDevice, int pcb, int page)
+{
+    return getDevice(getBlock(pcb, page)) == nDevice;
+}
+
+uint64_t pagingDevices::addPrefetch(int nDevice, int pcb, int page, bool writeBack,
+    int victimPcb, int victimPage)
+{
+    pagingDevice& device = _devices[nDevice];
+    uint64_t nServiceNS = 0;
+    if(writeBack)
+    {
+        nServiceNS += transferBlock(device, getBlock(victimPcb, victimPage));
+        device.lastBlock = -1;
+        device.stats.nWritebacks++;
+    }
+    nServiceNS += transferBlock(device, getBlock(pcb, page));
+    device.busyUntil += nServiceNS;
+    device.stats.serviceNS += nServiceNS;
+    device.stats.nPrefetched++;
+    return nServiceNS;
+}
+
+int pagingDevices::completeNext(uint64_t now, MemQueueItems& item)
+{
+    for(int i = 0; i < (int)_devices.size(); i++)
+    {
+        pagingDevice& device = _devices[i];
+        if(!device.busy || device.busyUntil > now)
+            continue;
+
+        device.busy = false;
+        if(!device.current.isCleaning)
+            device.stats.nServed++;
+        _nInFlight--;
+        item = device.current;
+        return i;
+    }
+    return -1;
+}
+
+uint64_t pagingDevices::nextCompletion()
+{
+    uint64_t nNext = 0;
+    for(pagingDevice& device : _devices)
+        if(device.busy && (nNext == 0 || device.busyUntil < nNext))
+            nNext = device.busyUntil;
+    return nNext;
+}
+
+std::vector<MemQueueItems> pagingDevices::clear()
+{
+    vector<MemQueueItems> items;
+    for(pagingDevice& device : _devices)
+    {
+        if(device.busy)
+            items.push_back(device.current);
+        device.busy = false;
+        items.insert(items.end(), device.queue.begin(), device.queue.end());
+        items.insert(items.end(), device.background.begin(), device.background.end());
+        device.queue.clear();
+        device.background.clear();
+    }
+    _nInFlight = 0;
+    return items;
+}
+
+int pagingDevices::queued()
+{
+    int nQueued = 0;
+    for(pagingDevice& device : _devices)
+        nQueued += device.queue.size() + device.background.size();
+    return nQueued;
+}
@@ -0,0 +1,184 @@
+/********************************************
+ * pagingDevice - Paging devices and I/O scheduling
+ * Page faults are queued on the swap device
+ * holding the page.  Each device serves one
+ * request at a time, picked from its queue by
+ * an I/O scheduler (FIFO, SSTF, SCAN or
+ * deadline), and takes as long as its seek,
+ * rotation and transfer model says.  With more
+ * than one device, faults are served in parallel.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * pagingDevice .h file for project
+ ********************************************/
+#ifndef PAGINGDEVICE_H
+#define PAGINGDEVICE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <stdint.h>
+
+// Most paging devices oss can be run with
+const int pagingDevicesMax = 8;
+
+// A faulted page waiting for, or being moved by, a paging device
+struct MemQueueItems {
+    int pcb;
+    int address;
+    int page;
+    int offset;
+    bool isWrite;
+    int64_t track;          // Track the page's swap block is on
+    uint64_t queuedTime;    // Sim time the fault was queued
+    uint64_t deadline;      // Sim time the deadline scheduler must start it by
+    bool isCleaning;        // Background write of a dirty page - nobody waits on it
+    int frame;              // Frame being cleaned
+};
+
+// Disk geometry and timing.  Swap blocks are striped over the
+// devices in runs, so each device holds 1/N of them and a run of a
+// process' pages - as long as the largest read-ahead window - is on
+// one device and can be read ahead in one I/O
+const int deviceStripeBlocks = 32;
+const int deviceBlocksPerTrack = 8;
+const uint64_t deviceSettleNS = 2000000;        // Any seek - accelerate and settle
+const uint64_t deviceTrackSeekNS = 220000;      // Plus this per track crossed
+const uint64_t deviceRotationNS = 4166666;      // Half a turn at 7200 rpm
+const uint64_t deviceTransferNS = 10240;        // One page at 100MB/s
+
+// Deadline scheduler - a request waiting this long is served next
+const uint64_t deviceDeadlineNS = 100000000;
+
+/***************************************************
+ * ioScheduler - Picks which queued request a
+ * device serves next.  Each device has its own,
+ * so a scheduler can keep state like the SCAN
+ * direction.
+ * *************************************************/
+class ioScheduler
+{
+    public:
+
+    virtual ~ioScheduler() {}
+
+    // Name used on the command line
+    virtual const char* getName() = 0;
+
+    // Index into queue of the request to serve next.  queue is
+    // never empty and is in arrival order
+    virtual int select(const std::deque<MemQueueItems>& queue, int64_t headTrack,
+        uint64_t now) = 0;
+};
+
+// Returns the scheduler with this name, or NULL if there is none
+ioScheduler* CreateIOScheduler(std::string);
+
+// Checks a name given on the command line
+bool IsIOSchedulerName(std::string);
+
+// Names of all the schedulers, for usage messages
+std::string GetIOSchedulerNames();
+
+// Per device statistics
+struct PagingDeviceStats {
+    long nServed;               // Requests completed
+    long nWritebacks;           // Dirty victims written out
+    long nMaxQueue;             // Longest the queue got
+    long nPrefetched;           // Pages read ahead along with a fault
+    long nCleaned;              // Dirty pages written in the background
+    uint64_t waitNS;            // Total time requests sat in the queue
+    uint64_t serviceNS;         // Total time the device was busy
+    uint64_t seekTracks;        // Total tracks the head moved
+};
+
+/***************************************************
+ * pagingDevices - The swap devices.  oss submits
+ * faults, starts every idle device that has work,
+ * and collects the requests that have completed
+ * by the current sim time.
+ * *************************************************/
+class pagingDevices
+{
+    private:
+
+        struct pagingDevice {
+            ioScheduler* scheduler;
+            std::deque<MemQueueItems> queue;
+            std::deque<MemQueueItems> background;   // Only served when queue is empty
+            bool busy;
+            MemQueueItems current;
+            uint64_t busyUntil;
+            int64_t headTrack;
+            int64_t lastBlock;  // Device block the head just read, -1 if none
+            PagingDeviceStats stats;
+        };
+
+        std::vector<pagingDevice> _devices;
+        int _nInFlight;
+
+        int64_t getBlock(int pcb, int page);
+        int getDevice(int64_t block);
+        int64_t getDeviceBlock(int64_t block);
+        uint64_t moveHead(pagingDevice&, int64_t track);
+        uint64_t transferBlock(pagingDevice&, int64_t block);
+
+    public:
+
+    // The scheduler name must pass IsIOSchedulerName
+    pagingDevices(int nDevices, std::string strScheduler);
+    ~pagingDevices();
+
+    // Queue a faulted page on the device holding it
+    void submit(MemQueueItems item, uint64_t now);
+
+    // Queue a page cleaning write at low priority.  Each device takes
+    // one at a time, so cleaning can hold a fault up by one write at
+    // most.  Returns false if the page's device already has one
+    bool submitBackground(MemQueueItems item, uint64_t now);
+
+    // Hands out the next request of an idle device with work to do.
+    // Returns the device, or -1 if there is none.  The caller loads
+    // the page, then calls beginService
+    int startNext(uint64_t now, MemQueueItems& item);
+
+    // Device starts moving its request.  A dirty victim is written
+    // to its own swap block first.  Returns the service time
+    uint64_t beginService(int device, uint64_t now, bool writeBack,
+        int victimPcb, int victimPage);
+
+    // Device starts a cleaning write.  If the page no longer needs
+    // writing it finishes straight away.  Returns the service time
+    uint64_t beginCleaning(int device, uint64_t now, bool write);
+
+    // Does the device serving a request hold this page's swap block
+    bool isOnDevice(int device, int pcb, int page);
+
+    // Reads another page in the device's current request, after
+    // writing out its dirty victim if it had to evict one.  The next
+    // block along the same track only costs its transfer; anything
+    // else needs a seek and rotation of its own.  Returns the extra
+    // service time
+    uint64_t addPrefetch(int device, int pcb, int page, bool writeBack,
+        int victimPcb, int victimPage);
+
+    // Hands out a request that has completed by now.  Returns the
+    // device, or -1 if none has
+    int completeNext(uint64_t now, MemQueueItems& item);
+
+    // Sim time the next in-flight request completes - 0 if none are
+    uint64_t nextCompletion();
+
+    // Removes every queued and in-flight request - for shutdown
+    std::vector<MemQueueItems> clear();
+
+    bool isIdle() { return _nInFlight == 0 && queued() == 0; }
+    int inFlight() { return _nInFlight; }
+    int queued();
+    int getDeviceCount() { return (int)_devices.size(); }
+    const char* getSchedulerName() { return _devices[0].scheduler->getName(); }
+    const PagingDeviceStats& getStats(int device) { return _devices[device].stats; }
+};
+
+#endif // PAGINGDEVICE_H
@@ -0,0 +1,102 @@
+/********************************************
+ * prefetcher - Sequential / strided read-ahead
+ * Stream detection and the adaptive window.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * prefetcher .cpp file for project
+ ********************************************/
+
+#include <algorithm>
+#include "pageTable.h"
+#include "prefetcher.h"
+
+using namespace std;
+
+prefetcher::prefetcher(int nPcbs, int nWindowMax)
+    : _streams(nPcbs), _nWindowMax(max(0, min(nWindowMax, prefetchWindowMax))),
+      _nUsed(0), _nWasted(0)
+{
+    for(int i = 0; i < nPcbs; i++)
+        resetProcess(i);
+}
+
+void prefetcher::resetProcess(int nPcb)
+{
+    Stream& stream = _streams[nPcb];
+    stream.lastPage = -1;
+    stream.stride = 0;
+    stream.nextPage = -1;
+    stream.window = min(prefetchWindowStart, _nWindowMax);
+    stream.used = 0;
+    stream.wasted = 0;
+}
+
+void prefetcher::onFault(int nPcb, int nPage, std::vector<int>& pages)
+{
+    pages.clear();
+    if(_nWindowMax == 0 || nPcb < 0 || nPcb >= (int)_streams.size())
+        return;
+
+    // The stream goes on if the fault lands where it was heading -
+    // just past the last read-ahead, or one stride on when the
+    // read-ahead didn't cover it
+    Stream& stream = _streams[nPcb];
+    const int nStride = nPage - stream.lastPage;
+    bool bStreaming = stream.lastPage >= 0 && stream.stride != 0
+        && (nPage == stream.nextPage || nStride == stream.stride);
+    if(bStreaming)
+    {
+        // Grow the window while read-ahead pays off, shrink it
+        // when more of it is wasted than used
+        if(stream.wasted > stream.used)
+            stream.window = max(1, stream.window / 2);
+        else if(stream.used > 0 && stream.wasted == 0)
+            stream.window = min(_nWindowMax, stream.window * 2);
+    }
+    else
+    {
+        // Not a stream yet - remember the stride and wait to see
+        // it again
+        stream.stride = stream.lastPage >= 0 ? nStride : 0;
+        stream.window = min(prefetchWindowStart, _nWindowMax);
+    }
+    stream.lastPage = nPage;
+    stream.used = 0;
+    stream.wasted = 0;
+    stream.nextPage = nPage + stream.stride;
+    if(!bStreaming)
+        return;
+
+    for(int i = 1; i <= stream.window; i++)
+    {
+        int nNext = nPage + stream.stride * i;
+        if(nNext < 0 || nNext >= pageCount)
+            break;
+        pages.push_back(nNext);
+    }
+    stream.nextPage = nPage + stream.stride * ((int)pages.size() + 1);
+}
+
+void prefetcher::onReadAhead(int nPcb, int nResident)
+{
+    if(nPcb < 0 || nPcb >= (int)_streams.size())
+        return;
+    Stream& stream = _streams[nPcb];
+    if(stream.stride != 0)
+        stream.nextPage = stream.lastPage + stream.stride * (nResident + 1);
+}
+
+void prefetcher::onUsed(int nPcb)
+{
+    _nUsed++;
+    if(nPcb >= 0 && nPcb < (int)_streams.size())
+        _streams[nPcb].used++;
+}
+
+void prefetcher::onWasted(int nPcb)
+{
+    _nWasted++;
+    if(nPcb >= 0 && nPcb < (int)_streams.size())
+        _streams[nPcb].wasted++;
+}
@@ -0,0 +1,69 @@
+/********************************************
+ * prefetcher - Sequential / strided read-ahead
+ * Watches each process' page faults for a
+ * steady stride.  Once two faults in a row are
+ * the same distance apart, the pages the stream
+ * will want next are read in along with the
+ * faulting page.  The read-ahead window doubles
+ * while the prefetched pages get used and is
+ * halved when they are evicted unused.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * prefetcher .h file for project
+ ********************************************/
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <vector>
+
+// Largest read-ahead window oss can be run with
+const int prefetchWindowMax = 32;
+// Window a newly detected stream starts with
+const int prefetchWindowStart = 2;
+
+class prefetcher
+{
+    private:
+        // What one PCB slot's fault stream looks like
+        struct Stream {
+            int lastPage;       // Page of the last fault, -1 if none
+            int stride;         // Distance between the last two faults
+            int nextPage;       // Where the stream faults next if read-ahead keeps up
+            int window;         // Pages to read ahead
+            long used;          // Read-ahead used since the last fault
+            long wasted;        // Read-ahead evicted unused since the last fault
+        };
+
+        std::vector<Stream> _streams;
+        int _nWindowMax;
+        long _nUsed;
+        long _nWasted;
+
+    public:
+
+    // nWindowMax of 0 turns read-ahead off
+    prefetcher(int nPcbs, int nWindowMax);
+
+    // A new process in the slot - forget its stream
+    void resetProcess(int pcb);
+
+    // A demand fault on page.  Fills pages with the pages to read
+    // ahead, nearest first - none unless a stream was detected
+    void onFault(int pcb, int page, std::vector<int>& pages);
+
+    // How many of those pages, from the first, are now resident.
+    // The rest weren't read, so the stream expects its next fault
+    // at the first of them
+    void onReadAhead(int pcb, int nResident);
+
+    // A prefetched page was used, or thrown away without being used
+    void onUsed(int pcb);
+    void onWasted(int pcb);
+
+    bool isEnabled() { return _nWindowMax > 0; }
+    long getUsed() { return _nUsed; }
+    long getWasted() { return _nWasted; }
+};
+
+#endif // PREFETCHER_H
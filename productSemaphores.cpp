@@ -77,7 +77,9 @@ void productSemaphores::Wait()
 {
     structSemaBuf.sem_num = 0;
     structSemaBuf.sem_op = -1;
-    structSemaBuf.sem_flg = 0;
+    // SEM_UNDO - if a process is killed while holding the semaphore
+    // the kernel releases it, so the others don't deadlock
+    structSemaBuf.sem_flg = SEM_UNDO;
     semop(_semid, &structSemaBuf, 1);
 //	cout << "wait: " << _semid << endl;
 }
@@ -87,7 +89,7 @@ void productSemaphores::Signal()
 {
     structSemaBuf.sem_num = 0;
     structSemaBuf.sem_op = 1;
-    structSemaBuf.sem_flg = 0;
+    structSemaBuf.sem_flg = SEM_UNDO;
     semop(_semid, &structSemaBuf, 1);
 //	cout << "signal: " << _semid << endl;
 }
@@ -33,61 +33,147 @@
 #include <sys/msg.h> 
 #include <string.h>
 #include <stdarg.h>  // For va_start, etc.
+#include <atomic>
 #include "productSemaphores.h"
+#include "spscRing.h"
+#include "frameTable.h"
+#include "pageTable.h"
+#include "asyncLog.h"
+#include "latencyHistogram.h"
+#include "workload.h"
 #include <assert.h>
 
 //***************************************************
 // Important Program Constants
 //***************************************************
-// Max Processes
-#define PROCESSES_MAX 20
-const int totalMemory = 256;
-const int pageCount = 32;
-const int pageSize = 1024;
-const int frameSize = pageSize;
-const int processSize = pageCount * pageSize;
+// Memory geometry is in pageTable.h
 const float readwriteProbability = 0.65f; // % Chance of a read operation
+const int tlbSize = 16;     // Entries in each user_proc's software TLB
 
-// The size of our product queue
-const int maxTimeToRunInSeconds = 3;
+// Wall seconds oss runs before it shuts the processes down
+const int maxTimeToRunInSeconds = 10;
 const char* ChildProcess = "./user_proc";
 
 //***************************************************
 // Enums
 //***************************************************
 enum MemRefType { READ, WRITE };
-enum ProcessActions { FRAME_READ, FRAME_WRITE, PROCESS_SHUTDOWN, OK };
+enum ProcessActions { FRAME_READ, FRAME_WRITE, PROCESS_SHUTDOWN, OK, FRAME_BATCH };
+enum TransportMode { TRANSPORT_RING, TRANSPORT_MSGQUEUE };
 //***************************************************
 // Structures
 //***************************************************
 typedef unsigned int uint;
 
-// Credit to Jared Diehl for his breakdown of these items
-struct PageTable {
-    uint frame;         // frame index
-    uint reference;     // second chance page replacement reference bit
-    uint protection;    // indicates if page is read=0 or write=1 (may not be needed)
-    uint dirty;         // indicates if page has been modified
-    uint valid;         // indicates if this PTE is loaded with a page
+// Most references a FRAME_BATCH request can carry - batchWrite
+// has one bit per reference
+const int maxBatchSize = 32;
+
+// Structure for messages between oss and user_proc - sent either
+// over the System V message queue or the shared memory rings.
+// A FRAME_BATCH request carries batchCount virtual addresses; the
+// reply carries the physical address of each one oss resolved, in
+// order, which may be fewer if it stopped at a seg fault
+struct message {
+    long type;
+    int  action;
+    int  procPid;
+    int  procIndex;
+    uint  memoryAddress;
+    int  batchCount;                    // References in batchAddress
+    uint batchWrite;                    // Bit n set - reference n is a write
+    uint batchAddress[maxBatchSize];
 };
 
-struct PCB {
-	pid_t pid;
-	uint currentFrame;
-	PageTable ptable[pageCount]; // 32 indexes at 1k Each
+// Each PCB slot gets its own request and response ring.  Only one
+// request is ever outstanding per process, so they can be small
+const unsigned int channelRingSize = 8;
+struct MessageChannel {
+    spscRing<message, channelRingSize> request;    // user_proc -> oss
+    spscRing<message, channelRingSize> response;   // oss -> user_proc
 };
 
-struct OssHeader {
-    uint simClockSeconds;     // System Clock - Seconds
-    uint simClockNanoseconds; // System Clock - Nanoseconds
-	PCB pcb[PROCESSES_MAX];
+// Per-process software TLB entry - direct mapped by page number.
+// Lives in user_proc memory and is flushed when tlbGeneration moves
+struct TlbEntry {
+    int page;           // page cached in this slot (-1 if empty)
+    uint frame;         // frame the page was loaded in
+    uint dirty;         // page is known dirty, so writes can hit too
 };
 
-struct MemQueueItems {
-    int pcb;
-    int address;
+struct OssHeader {
+    // Set by oss before any user_proc starts, then only read
+    uint transportMode;       // TransportMode chosen by oss
+    int requestEventFd;       // eventfd oss sleeps on - inherited by user_proc
+    uint tlbEnabled;          // user_proc may resolve hits from its TLB
+    uint batchSize;           // References per user_proc request - 1 is unbatched
+    uint logLevel;            // LogLevel for user_proc
+    WorkloadParams workload;  // Reference pattern user_proc generates
+    // The hot shared words each get a cache line of their own
+    alignas(cacheLineSize) std::atomic<uint64_t> simClockNS;   // System Clock - Nanoseconds, lock-free
+    alignas(cacheLineSize) std::atomic<uint> requestsPending;  // Requests sent but not yet picked up by oss
+    std::atomic<uint> ossSleeping;      // oss is (about to be) asleep on its events
+    LogArea log;                // Log rings drained by oss' log writer
+    // The memory geometry and where the parts sized by it and by
+    // the process count were put.  They follow the header in this order
+    uint nFrames;
+    uint nPages;
+    uint nPageSize;
+    uint nProcesses;
+    uint64_t segmentSize;
+    relativeArray<MessageChannel> channel;      // One per PCB
+    relativeArray<latencyHistogram> tlbHitLatency;  // Wall time of TLB hits - one writer each
+	relativeArray<PCB> pcb;                     // processesMax PCBs
+    relativeArray<PageTable> pageTables;        // pageCount PTEs for each PCB
+    relativeArray<FrameTableEntry> frameTable;  // System-wide - all processes compete for these
 };
 
+// Rounds up to a whole cache line
+inline size_t AlignToCacheLine(size_t nSize)
+{
+    return (nSize + cacheLineSize - 1) & ~(size_t)(cacheLineSize - 1);
+}
+
+// Size of the shared segment for the current geometry and process
+// count - the header, then the message channels, log channels and
+// TLB latencies, the PCBs, their page tables and the frame table
+inline size_t GetSegmentSize()
+{
+    return AlignToCacheLine(sizeof(OssHeader))
+        + AlignToCacheLine(sizeof(MessageChannel) * (size_t)processesMax)
+        + AlignToCacheLine(sizeof(LogChannel) * (size_t)(processesMax + 1))
+        + AlignToCacheLine(sizeof(latencyHistogram) * (size_t)processesMax)
+        + AlignToCacheLine(sizeof(PCB) * (size_t)processesMax)
+        + AlignToCacheLine(sizeof(PageTable) * (size_t)processesMax * pageCount)
+        + sizeof(FrameTableEntry) * (size_t)totalMemory;
+}
+
+// oss lays out a new segment for the current geometry and process
+// count and records it in the header
+inline void LayoutSegment(OssHeader* ossHeader)
+{
+    char* next = (char*)ossHeader + AlignToCacheLine(sizeof(OssHeader));
+    ossHeader->channel.set((MessageChannel*)next);
+    next += AlignToCacheLine(sizeof(MessageChannel) * (size_t)processesMax);
+    ossHeader->log.channel.set((LogChannel*)next);
+    ossHeader->log.channelCount = processesMax + 1;
+    next += AlignToCacheLine(sizeof(LogChannel) * (size_t)(processesMax + 1));
+    ossHeader->tlbHitLatency.set((latencyHistogram*)next);
+    next += AlignToCacheLine(sizeof(latencyHistogram) * (size_t)processesMax);
+    ossHeader->pcb.set((PCB*)next);
+    next += AlignToCacheLine(sizeof(PCB) * (size_t)processesMax);
+    ossHeader->pageTables.set((PageTable*)next);
+    next += AlignToCacheLine(sizeof(PageTable) * (size_t)processesMax * pageCount);
+    ossHeader->frameTable.set((FrameTableEntry*)next);
+
+    ossHeader->nFrames = totalMemory;
+    ossHeader->nPages = pageCount;
+    ossHeader->nPageSize = pageSize;
+    ossHeader->nProcesses = processesMax;
+    ossHeader->segmentSize = GetSegmentSize();
+    LinkPageTables(ossHeader->pcb.get(), processesMax, ossHeader->pageTables.get());
+}
+
 const key_t KEY_SHMEM = 0x54320;  // Shared key
 int shm_id; // Shared Mem ident
 char* shm_addr;
@@ -97,16 +183,82 @@ char* shm_addr;
 //***************************************************
 const key_t KEY_MESSAGE_QUEUE = 0x54324;
 
-// Structure for message queue 
-struct message {
-    long type;
-    int  action;
-    int  procPid;
-    int  procIndex;
-    uint  memoryAddress;
-} msg;
+struct message msg;
 
 const long OSS_MQ_TYPE = 1000;
+// System V message sizes don't include the type field
+const size_t messageSize = sizeof(message) - sizeof(long);
+
+// Transport helpers - each sends or receives over whichever
+// transport oss set up in the shared header.
+// user_proc -> oss request
+bool SendToOss(OssHeader* ossHeader, int msgid, message& m)
+{
+    m.type = OSS_MQ_TYPE;
+    // Counted before it is sent so oss never sees it go negative
+    ossHeader->requestsPending++;
+    bool bSent;
+    if(ossHeader->transportMode == TRANSPORT_MSGQUEUE)
+        bSent = msgsnd(msgid, (void *) &m, messageSize, 0) == 0;
+    else
+        bSent = ossHeader->channel[m.procIndex].request.push(m);
+    if(!bSent)
+    {
+        ossHeader->requestsPending--;
+        return false;
+    }
+
+    // Ring oss' doorbell, but only if it is asleep
+    if(ossHeader->ossSleeping)
+    {
+        uint64_t nOne = 1;
+        write(ossHeader->requestEventFd, &nOne, sizeof(nOne));
+    }
+    return true;
+}
+
+// user_proc waits for oss' response
+bool ReceiveFromOss(OssHeader* ossHeader, int msgid, int procIndex, pid_t pid, message& m)
+{
+    if(ossHeader->transportMode == TRANSPORT_MSGQUEUE)
+        return msgrcv(msgid, (void *) &m, messageSize, pid, 0) > 0;
+    return ossHeader->channel[procIndex].response.popWait(m);
+}
+
+// oss -> user_proc response
+bool SendToProcess(OssHeader* ossHeader, int msgid, int procIndex, message& m)
+{
+    m.type = ossHeader->pcb[procIndex].pid;
+    if(ossHeader->transportMode == TRANSPORT_MSGQUEUE)
+        return msgsnd(msgid, (void *) &m, messageSize, 0) == 0;
+    return ossHeader->channel[procIndex].response.push(m);
+}
+
+// oss picks up the next request from any process without blocking.
+// The rings are polled round-robin so no process can starve the rest
+bool ReceiveFromAnyProcess(OssHeader* ossHeader, int msgid, int nProcesses, message& m)
+{
+    static int nNextChannel = 0;
+    if(ossHeader->transportMode == TRANSPORT_MSGQUEUE)
+    {
+        if(msgrcv(msgid, (void *) &m, messageSize, OSS_MQ_TYPE, IPC_NOWAIT) <= 0)
+            return false;
+        ossHeader->requestsPending--;
+        return true;
+    }
+    for(int i = 0; i < nProcesses; i++)
+    {
+        int nChannel = (nNextChannel + i) % nProcesses;
+        if(ossHeader->channel[nChannel].request.pop(m))
+        {
+            m.procIndex = nChannel;
+            nNextChannel = (nChannel + 1) % nProcesses;
+            ossHeader->requestsPending--;
+            return true;
+        }
+    }
+    return false;
+}
 
 //***************************************************
 // Semaphores
@@ -298,18 +450,76 @@ std::string string_format(const std::string fmt, ...)
     return str;
 }
 
-// Writes a log file
-void LogItem(std::string input, std::string LogFileName)
+//***************************************************
+// Simulated Clock
+//***************************************************
+// The clock is one 64 bit nanosecond count in shared memory.  It is
+// advanced with an atomic fetch-add and read without locks
+const uint64_t nsPerSecond = 1000000000ULL;
+
+// Advances the clock and returns the new time
+inline uint64_t AdvanceSimClock(OssHeader* ossHeader, uint64_t nNanoseconds)
+{
+    return ossHeader->simClockNS.fetch_add(nNanoseconds) + nNanoseconds;
+}
+
+// Moves the clock forward to nTime, unless it is already past it
+inline void AdvanceSimClockTo(OssHeader* ossHeader, uint64_t nTime)
+{
+    uint64_t nCurrent = ossHeader->simClockNS.load();
+    while(nCurrent < nTime && !ossHeader->simClockNS.compare_exchange_weak(nCurrent, nTime))
+        ;
+}
+
+inline uint64_t GetSimClock(OssHeader* ossHeader)
 {
+    return ossHeader->simClockNS.load();
+}
 
-    std::cout << input.c_str() << std::endl;
+inline uint GetSimSeconds(uint64_t nTime) { return nTime / nsPerSecond; }
+inline uint GetSimNanoseconds(uint64_t nTime) { return nTime % nsPerSecond; }
+
+// Formats a sim time as Seconds:Nanoseconds for the logs
+std::string FormatSimTime(uint64_t nTime)
+{
+    return string_format("%.6u:%.10u", GetSimSeconds(nTime), GetSimNanoseconds(nTime));
+}
+
+// Only lines at or below this level are logged.  oss sets it
+// from the command line and user_proc copies it from the header
+int logLevel = LOGLEVEL_INFO;
+
+// Benchmark builds can compile trace logging out altogether
+// with -DOSS_NO_TRACE_LOG (make NOTRACE=1)
+#ifdef OSS_NO_TRACE_LOG
+const int maxLogLevel = LOGLEVEL_VERBOSE;
+#else
+const int maxLogLevel = LOGLEVEL_TRACE;
+#endif
+#define LogEnabled(level) ((level) <= maxLogLevel && (level) <= logLevel)
+
+// Logs with LogItem only if level is enabled.  When it isn't,
+// none of the arguments are evaluated, so nothing is formatted
+#define LOG_AT(level, ...) do { if(LogEnabled(level)) LogItem(__VA_ARGS__); } while(0)
+
+// Once a process has attached to shared memory its log lines go
+// through its own ring in the log area; oss' log writer writes them
+// out.  Until then, or if there is no log area, they are written
+// straight to the file
+LogArea* logArea = NULL;
+int logChannel = 0;
+
+// Writes one line straight to the screen and the log file
+void WriteLogLine(const std::string& strLine, const std::string& LogFileName)
+{
+    std::cout << strLine.c_str() << std::endl;
 
     // Open a file to write
     std::ofstream logFile (LogFileName.c_str(), 
             std::ofstream::out | std::ofstream::app);
     if (logFile.is_open())
     {
-        logFile << input.c_str() << std::endl;
+        logFile << strLine.c_str() << std::endl;
         logFile.close();
     }
     else
@@ -318,36 +528,28 @@ void LogItem(std::string input, std::string LogFileName)
     }
 }
 
+// Writes a log file
+void LogItem(std::string input, std::string LogFileName)
+{
+    if(logArea == NULL)
+    {
+        WriteLogLine(input, LogFileName);
+        return;
+    }
+    input.push_back('\n');
+    LogWrite(logArea, logChannel, input.data(), input.size());
+}
+
 // Writes a special kind of log that logs exactly the same thing
 // to both a log in a specified file and to the screen
-void LogItem(std::string strSystem, int timeSeconds, int timeNanoseconds, 
+void LogItem(std::string strSystem, uint64_t simTime, 
     std::string mainText, int PID, int Index, std::string LogFileName)
 {
-
-    std::cout << string_format("%s%.2d %.6d:%.10d\t%s PID %d",
-            strSystem.c_str(), 
-            Index,
-            timeSeconds, 
-            timeNanoseconds, 
-            mainText.c_str(), PID) << std::endl;
-
-    // Open a file to write
-    std::ofstream logFile (LogFileName.c_str(), 
-            std::ofstream::out | std::ofstream::app);
-    if (logFile.is_open())
-    {
-        logFile << string_format("%s%.2d %.6d:%.10d\t%s PID %d",
+    LogItem(string_format("%s%.2d %s\t%s PID %d",
             strSystem.c_str(), 
             Index,
-            timeSeconds, 
-            timeNanoseconds, 
-            mainText.c_str(), PID) << std::endl;
-        logFile.close();
-    }
-    else
-    {
-        perror("Unable to write to log file");
-    }
+            FormatSimTime(simTime).c_str(), 
+            mainText.c_str(), PID), LogFileName);
 }
 
 #endif // SHAREDSTRUCTURES_H
\ No newline at end of file
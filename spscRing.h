@@ -0,0 +1,130 @@
+/********************************************
+ * spscRing - Single producer/single consumer
+ * ring buffer that lives in shared memory.
+ * One process pushes, one process pops - no
+ * locks needed.  A consumer that runs out of
+ * items sleeps on a futex and the producer
+ * only makes the wake syscall if it is asleep.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * spscRing .h file for project
+ ********************************************/
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <unistd.h>
+#include <errno.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <time.h>
+
+// Times a consumer polls before it goes to sleep on the futex
+const int ringSpinCount = 64;
+
+// Futex helpers - the futex word is shared between processes,
+// so the non-private futex operations are used
+inline int futexWait(std::atomic<unsigned int>* addr, unsigned int expected,
+    const struct timespec* timeout = NULL)
+{
+    return syscall(SYS_futex, reinterpret_cast<unsigned int*>(addr),
+        FUTEX_WAIT, expected, timeout, NULL, 0);
+}
+
+inline int futexWake(std::atomic<unsigned int>* addr, int nWaiters = 1)
+{
+    return syscall(SYS_futex, reinterpret_cast<unsigned int*>(addr),
+        FUTEX_WAKE, nWaiters, NULL, NULL, 0);
+}
+
+// Size must be a power of 2.  T must be trivially copyable since
+// the ring is shared between processes
+template <typename T, unsigned int Size>
+struct spscRing
+{
+    static_assert((Size & (Size - 1)) == 0, "spscRing Size must be a power of 2");
+
+    std::atomic<unsigned int> head;     // Next slot to pop (consumer owned)
+    std::atomic<unsigned int> tail;     // Next slot to push (producer owned) - futex word
+    std::atomic<unsigned int> sleeping; // Consumer is asleep on the futex
+    T items[Size];
+
+    // Only call when neither side is using the ring
+    void init()
+    {
+        head = 0;
+        tail = 0;
+        sleeping = 0;
+    }
+
+    bool empty()
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    // Items waiting to be popped
+    unsigned int size()
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    // Producer side - returns false if the ring is full
+    bool push(const T& item)
+    {
+        unsigned int nTail = tail.load(std::memory_order_relaxed);
+        if(nTail - head.load(std::memory_order_acquire) == Size)
+            return false;
+        items[nTail & (Size - 1)] = item;
+        tail.store(nTail + 1, std::memory_order_seq_cst);
+
+        // Only wake the consumer if it is sleeping
+        if(sleeping.load(std::memory_order_seq_cst))
+            futexWake(&tail);
+        return true;
+    }
+
+    // Consumer side - returns false if the ring is empty
+    bool pop(T& item)
+    {
+        unsigned int nHead = head.load(std::memory_order_relaxed);
+        if(nHead == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[nHead & (Size - 1)];
+        head.store(nHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side - spin briefly, then sleep until an item is pushed.
+    // Returns false if interrupted by a signal
+    bool popWait(T& item)
+    {
+        for(int i = 0; i < ringSpinCount; i++)
+        {
+            if(pop(item))
+                return true;
+            // Give the producer the CPU in case it shares our core
+            sched_yield();
+        }
+        while(!pop(item))
+        {
+            // Announce we are going to sleep, then re-check so a
+            // push between the two can't be missed
+            sleeping.store(1, std::memory_order_seq_cst);
+            unsigned int nTail = tail.load(std::memory_order_seq_cst);
+            if(nTail == head.load(std::memory_order_relaxed))
+            {
+                if(futexWait(&tail, nTail) == -1 && errno == EINTR)
+                {
+                    sleeping.store(0, std::memory_order_relaxed);
+                    return false;
+                }
+            }
+            sleeping.store(0, std::memory_order_relaxed);
+        }
+        return true;
+    }
+};
+
+#endif // SPSCRING_H
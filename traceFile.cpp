@@ -0,0 +1,264 @@
+/********************************************
+ * traceFile - Memory reference traces
+ * Varint/delta encoding of memory references
+ * to a binary file, and a memory mapped reader
+ * to stream them back.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * traceFile .cpp file for project
+ ********************************************/
+
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "traceFile.h"
+
+using namespace std;
+
+// Records are buffered and written out in blocks this size
+const size_t traceBufferSize = 65536;
+
+// Signed deltas are zigzag encoded so small moves either way
+// pack into a single byte
+static inline uint64_t ZigZagEncode(int64_t n) { return ((uint64_t)n << 1) ^ (uint64_t)(n >> 63); }
+static inline int64_t ZigZagDecode(uint64_t n) { return (int64_t)(n >> 1) ^ -(int64_t)(n & 1); }
+
+/***************************************************
+ * traceWriter
+ * *************************************************/
+traceWriter::traceWriter() : _fd(-1), _lastTime(0), _nRecords(0)
+{
+}
+
+traceWriter::~traceWriter()
+{
+    close();
+}
+
+bool traceWriter::open(string strFile, uint32_t nPageSize, uint32_t nPageCount,
+    uint32_t nProcessCount)
+{
+    _fd = ::open(strFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(_fd == -1)
+        return false;
+
+    TraceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, traceMagic, sizeof(header.magic));
+    header.version = traceVersion;
+    header.pageSize = nPageSize;
+    header.pageCount = nPageCount;
+    header.processCount = nProcessCount;
+    header.recordCount = 0;
+    if(::write(_fd, &header, sizeof(header)) != sizeof(header))
+    {
+        ::close(_fd);
+        _fd = -1;
+        return false;
+    }
+    _buffer.reserve(traceBufferSize);
+    _lastAddress.clear();
+    _lastTime = 0;
+    _nRecords = 0;
+    return true;
+}
+
+void traceWriter::putVarint(uint64_t n)
+{
+    while(n >= 0x80)
+    {
+        _buffer.push_back((uint8_t)(n | 0x80));
+        n >>= 7;
+    }
+    _buffer.push_back((uint8_t)n);
+}
+
+bool traceWriter::write(const TraceRecord& rec)
+{
+    if(_fd == -1 || rec.procIndex < 0)
+        return false;
+    if((size_t)rec.procIndex >= _lastAddress.size())
+        _lastAddress.resize(rec.procIndex + 1, 0);
+
+    putVarint(((uint64_t)rec.procIndex << 2) | rec.type);
+    if(rec.type != TRACE_EXIT)
+    {
+        putVarint(ZigZagEncode((int64_t)rec.address - (int64_t)_lastAddress[rec.procIndex]));
+        _lastAddress[rec.procIndex] = rec.address;
+    }
+    else
+        _lastAddress[rec.procIndex] = 0;
+    // The sim clock never runs backwards
+    putVarint(rec.simTime > _lastTime ? rec.simTime - _lastTime : 0);
+    if(rec.simTime > _lastTime)
+        _lastTime = rec.simTime;
+    _nRecords++;
+
+    if(_buffer.size() >= traceBufferSize - 32)
+        return flush();
+    return true;
+}
+
+bool traceWriter::flush()
+{
+    size_t nWritten = 0;
+    while(nWritten < _buffer.size())
+    {
+        ssize_t n = ::write(_fd, _buffer.data() + nWritten, _buffer.size() - nWritten);
+        if(n == -1 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return false;
+        nWritten += n;
+    }
+    _buffer.clear();
+    return true;
+}
+
+bool traceWriter::close()
+{
+    if(_fd == -1)
+        return true;
+    bool bSuccess = flush();
+
+    // Now the record count is known
+    bSuccess = bSuccess && pwrite(_fd, &_nRecords, sizeof(_nRecords),
+        offsetof(TraceFileHeader, recordCount)) == sizeof(_nRecords);
+    ::close(_fd);
+    _fd = -1;
+    return bSuccess;
+}
+
+/***************************************************
+ * traceReader
+ * *************************************************/
+traceReader::traceReader() : _data(NULL), _size(0), _next(NULL), _end(NULL), _lastTime(0),
+    _nAddressLimit(0), _bCorrupt(false)
+{
+    memset(&_header, 0, sizeof(_header));
+}
+
+traceReader::~traceReader()
+{
+    close();
+}
+
+bool traceReader::open(string strFile)
+{
+    close();
+    int fd = ::open(strFile.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return false;
+    struct stat st;
+    if(fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(TraceFileHeader))
+    {
+        ::close(fd);
+        errno = EINVAL;
+        return false;
+    }
+    void* pData = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(pData == MAP_FAILED)
+        return false;
+
+    _data = (const uint8_t*)pData;
+    _size = st.st_size;
+    memcpy(&_header, _data, sizeof(_header));
+    if(memcmp(_header.magic, traceMagic, sizeof(traceMagic)) != 0
+        || _header.version != traceVersion)
+    {
+        close();
+        errno = EINVAL;
+        return false;
+    }
+    // user_proc's deliberate bad references land less than one
+    // address space past the end, so a record beyond that did not
+    // come from oss
+    _nAddressLimit = 2 * (uint64_t)_header.pageCount * _header.pageSize;
+
+    // Replay reads straight through, so let the kernel read ahead
+    madvise(pData, _size, MADV_SEQUENTIAL);
+    _end = _data + _size;
+    rewind();
+    return true;
+}
+
+void traceReader::rewind()
+{
+    _next = _data + sizeof(TraceFileHeader);
+    _lastAddress.clear();
+    _lastTime = 0;
+    _bCorrupt = false;
+}
+
+bool traceReader::getVarint(uint64_t& n)
+{
+    n = 0;
+    for(int nShift = 0; _next < _end && nShift < 64; nShift += 7)
+    {
+        uint8_t b = *_next++;
+        n |= (uint64_t)(b & 0x7f) << nShift;
+        if(!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool traceReader::next(TraceRecord& rec)
+{
+    uint64_t nKey, nDelta;
+    if(_data == NULL || !getVarint(nKey))
+        return false;
+    rec.procIndex = (int)(nKey >> 2);
+    rec.type = (int)(nKey & 3);
+    if((nKey >> 2) >= _header.processCount || rec.type > TRACE_EXIT)
+    {
+        _bCorrupt = true;
+        return false;
+    }
+    if((size_t)rec.procIndex >= _lastAddress.size())
+        _lastAddress.resize(rec.procIndex + 1, 0);
+
+    if(rec.type != TRACE_EXIT)
+    {
+        if(!getVarint(nDelta))
+        {
+            _bCorrupt = true;
+            return false;
+        }
+        int64_t nAddress = (int64_t)_lastAddress[rec.procIndex] + ZigZagDecode(nDelta);
+        if(nAddress < 0 || (uint64_t)nAddress >= _nAddressLimit)
+        {
+            _bCorrupt = true;
+            return false;
+        }
+        rec.address = (uint)nAddress;
+        _lastAddress[rec.procIndex] = rec.address;
+    }
+    else
+    {
+        rec.address = 0;
+        _lastAddress[rec.procIndex] = 0;
+    }
+    if(!getVarint(nDelta))
+    {
+        _bCorrupt = true;
+        return false;
+    }
+    _lastTime += nDelta;
+    rec.simTime = _lastTime;
+    return true;
+}
+
+void traceReader::close()
+{
+    if(_data != NULL)
+        munmap((void*)_data, _size);
+    _data = _next = _end = NULL;
+    _size = 0;
+}
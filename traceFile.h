@@ -0,0 +1,105 @@
+/********************************************
+ * traceFile - Memory reference traces
+ * Writes and reads compact binary traces of
+ * the memory references oss handles so a run
+ * can be replayed exactly.  Each record is
+ * varint packed: process index and type, the
+ * address as a delta from that process' last
+ * address, and the sim time as a delta from
+ * the previous record.  Traces are read back
+ * through a memory map.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * traceFile .h file for project
+ ********************************************/
+#ifndef TRACEFILE_H
+#define TRACEFILE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+
+enum TraceRecordType { TRACE_READ, TRACE_WRITE, TRACE_EXIT };
+
+struct TraceRecord {
+    int procIndex;      // PCB index that made the reference
+    int type;           // TraceRecordType
+    uint address;       // Virtual address - 0 for TRACE_EXIT
+    uint64_t simTime;   // Sim time the reference reached oss
+};
+
+// On-disk header.  The geometry the trace was recorded with is
+// kept so it is replayed with the same address space.  recordCount
+// is filled in when the trace is closed - a trace that was never
+// closed is read to its end
+const char traceMagic[8] = { 'O', 'S', 'S', 'T', 'R', 'A', 'C', 'E' };
+const uint32_t traceVersion = 2;
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pageSize;
+    uint32_t pageCount;     // Pages per process
+    uint32_t processCount;  // PCB slots - every procIndex is below this
+    uint64_t recordCount;
+};
+
+class traceWriter
+{
+    private:
+        int _fd;
+        std::vector<uint8_t> _buffer;
+        std::vector<uint> _lastAddress;     // Per process
+        uint64_t _lastTime;
+        uint64_t _nRecords;
+
+        void putVarint(uint64_t);
+        bool flush();
+
+    public:
+
+    traceWriter();
+    ~traceWriter();
+
+    bool open(std::string strFile, uint32_t nPageSize, uint32_t nPageCount,
+        uint32_t nProcessCount);
+    bool write(const TraceRecord&);
+    bool close();
+    bool isOpen() { return _fd != -1; }
+    uint64_t getRecordCount() { return _nRecords; }
+};
+
+class traceReader
+{
+    private:
+        const uint8_t* _data;       // Mapped file
+        size_t _size;
+        const uint8_t* _next;       // Next record to decode
+        const uint8_t* _end;
+        std::vector<uint> _lastAddress;
+        uint64_t _lastTime;
+        TraceFileHeader _header;
+        uint64_t _nAddressLimit;    // No recorded address reaches this
+        bool _bCorrupt;
+
+        bool getVarint(uint64_t&);
+
+    public:
+
+    traceReader();
+    ~traceReader();
+
+    bool open(std::string strFile);
+    // Decodes the next record.  Returns false at the end of the trace,
+    // or at a record that is cut short or out of range
+    bool next(TraceRecord&);
+    // Did next stop at a bad record rather than the end
+    bool isCorrupt() { return _bCorrupt; }
+    // Start again from the first record
+    void rewind();
+    void close();
+    const TraceFileHeader& getHeader() { return _header; }
+};
+
+#endif // TRACEFILE_H
@@ -0,0 +1,174 @@
+/********************************************
+ * transportBench - Message Transport Benchmark
+ * Measures the oss <-> user_proc request/response
+ * round trip over both transports: the System V
+ * message queue and the shared memory rings.  An
+ * echo process plays the part of oss.
+ *
+ * Brett Huffman
+ * transportBench CPP file for oss project
+ ********************************************/
+
+#include <iostream>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "sharedStructures.h"
+
+using namespace std;
+
+// Forward declarations
+static void show_usage(std::string);
+static bool runBenchmark(TransportMode, const char*, OssHeader*, int, int);
+static bool ReceiveRequestBlocking(OssHeader*, int, message&);
+
+// Returns a monotonic timestamp in nanoseconds
+static long GetTimeNS()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+int main(int argc, char* argv[])
+{
+    int opt;
+    int nIterations = 100000;
+
+    while ((opt = getopt(argc, argv, "hn:")) != -1) {
+        switch (opt) {
+            case 'h':
+                show_usage(argv[0]);
+                return EXIT_SUCCESS;
+            case 'n':
+                nIterations = max(1, atoi(optarg));
+                break;
+            default:
+                show_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    // Private IPC objects so a running oss is not disturbed
+    int msgid = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+    if (msgid == -1) {
+        perror("transportBench: Error creating Message Queue");
+        return EXIT_FAILURE;
+    }
+    int shmid = shmget(IPC_PRIVATE, GetSegmentSize(), IPC_CREAT | 0600);
+    if (shmid == -1) {
+        perror("transportBench: Error allocating shared memory");
+        msgctl(msgid, IPC_RMID, NULL);
+        return EXIT_FAILURE;
+    }
+    OssHeader* ossHeader = (OssHeader*)shmat(shmid, NULL, 0);
+    if (ossHeader == (void*)-1) {
+        perror("transportBench: Error attaching shared memory");
+        shmctl(shmid, IPC_RMID, NULL);
+        msgctl(msgid, IPC_RMID, NULL);
+        return EXIT_FAILURE;
+    }
+    LayoutSegment(ossHeader);
+
+    cout << "Round trips per transport: " << nIterations << endl << endl;
+    cout << "Transport\tMean ns\t\tp50 ns\t\tp99 ns\t\tRequests/sec" << endl;
+
+    bool bSuccess = runBenchmark(TRANSPORT_MSGQUEUE, "msgqueue", ossHeader, msgid, nIterations)
+        && runBenchmark(TRANSPORT_RING, "ring    ", ossHeader, msgid, nIterations);
+
+    shmdt(ossHeader);
+    shmctl(shmid, IPC_RMID, NULL);
+    msgctl(msgid, IPC_RMID, NULL);
+    return bSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Forks an echo process and times nIterations request/response
+// round trips from this process to it
+static bool runBenchmark(TransportMode mode, const char* name, OssHeader* ossHeader,
+    int msgid, int nIterations)
+{
+    ossHeader->transportMode = mode;
+    ossHeader->channel[0].request.init();
+    ossHeader->channel[0].response.init();
+    // Responses are addressed to the requesting process
+    ossHeader->pcb[0].pid = getpid();
+
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+        perror("transportBench: Could not fork process");
+        return false;
+    }
+    if(pid == 0)
+    {
+        // Echo process - answer every request like oss would
+        message m;
+        while(ReceiveRequestBlocking(ossHeader, msgid, m))
+        {
+            int nAction = m.action;
+            m.action = OK;
+            SendToProcess(ossHeader, msgid, 0, m);
+            if(nAction == PROCESS_SHUTDOWN)
+                break;
+        }
+        _exit(EXIT_SUCCESS);
+    }
+
+    vector<long> latencies(nIterations);
+    message m;
+    long startTime = GetTimeNS();
+    for(int i = 0; i < nIterations; i++)
+    {
+        long requestTime = GetTimeNS();
+        m.action = FRAME_READ;
+        m.procIndex = 0;
+        m.procPid = getpid();
+        m.memoryAddress = i % processSize;
+        SendToOss(ossHeader, msgid, m);
+        ReceiveFromOss(ossHeader, msgid, 0, getpid(), m);
+        latencies[i] = GetTimeNS() - requestTime;
+    }
+    long totalTime = GetTimeNS() - startTime;
+
+    // Stop the echo process
+    m.action = PROCESS_SHUTDOWN;
+    m.procIndex = 0;
+    SendToOss(ossHeader, msgid, m);
+    ReceiveFromOss(ossHeader, msgid, 0, getpid(), m);
+    waitpid(pid, NULL, 0);
+
+    sort(latencies.begin(), latencies.end());
+    long nSum = 0;
+    for(int i = 0; i < nIterations; i++)
+        nSum += latencies[i];
+
+    cout << name << "\t"
+         << nSum / nIterations << "\t\t"
+         << latencies[nIterations / 2] << "\t\t"
+         << latencies[(int)(nIterations * 0.99)] << "\t\t"
+         << GetStringFromFloat((float)nIterations * 1000000000.0f / (float)totalTime)
+         << endl;
+    return true;
+}
+
+// The echo process blocks for the next request on channel 0
+static bool ReceiveRequestBlocking(OssHeader* ossHeader, int msgid, message& m)
+{
+    if(ossHeader->transportMode == TRANSPORT_MSGQUEUE)
+        return msgrcv(msgid, (void *) &m, messageSize, OSS_MQ_TYPE, 0) > 0;
+    return ossHeader->channel[0].request.popWait(m);
+}
+
+// Handle errors in input arguments by showing usage screen
+static void show_usage(std::string name)
+{
+    std::cerr << std::endl
+              << name << " - transport benchmark for the oss app" << std::endl
+              << std::endl
+              << "Usage:\t" << name << " [-h]" << std::endl
+              << "\t" << name << " [-n iterations]" << std::endl
+              << "Options:" << std::endl
+              << "  -h   Describe how the program should be run, then terminate" << std::endl
+              << "  -n   number of round trips per transport - default 100000" << std::endl
+              << std::endl << std::endl;
+}
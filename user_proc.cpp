@@ -66,9 +66,6 @@ int main(int argc, char* argv[])
     // Pid used throughout child
     const pid_t nPid = getpid();
 
-    // Seed the randomizer with the PID
-    srand(time(0) ^ nPid);
-
     time_t secondsStart = time(NULL);   // Start time
 
     // Open the connection with the Message Queue
@@ -111,134 +108,185 @@ int main(int argc, char* argv[])
 
     // Get the queue header
     struct OssHeader* ossHeader = (struct OssHeader*) (shm_addr);
+    // Use the memory geometry and process count oss laid the
+    // segment out with
+    SetMemoryGeometry(ossHeader->nFrames, ossHeader->nPages, ossHeader->nPageSize);
+    SetProcessCount(ossHeader->nProcesses);
+    PCB& pcb = ossHeader->pcb[nItemToProcess];
+
+    // Our references come from the workload oss was started with.
+    // Its generator, seeded with the PID, makes every random choice
+    workloadGenerator workload(ossHeader->workload, time(0) ^ nPid);
+    workloadRandom& random = workload.random();
+
+    // Log through our ring in shared memory, at oss' log level
+    logArea = &ossHeader->log;
+    logChannel = nItemToProcess;
+    logLevel = ossHeader->logLevel;
+
+    // Software TLB - resident pages are resolved locally.  It is
+    // flushed whenever oss moves our PCB's tlbGeneration
+    TlbEntry tlb[tlbSize];
+    for(int i = 0; i < tlbSize; i++)
+        tlb[i].page = -1;
+    uint nTlbGeneration = pcb.tlbGeneration;
+
+    // TLB misses are sent to oss in batches of this many.  With a
+    // batch of 1 each one is sent as a plain FRAME_READ/FRAME_WRITE
+    const int nBatchSize = ossHeader->batchSize;
+    message batch;
+    batch.batchCount = 0;
+    batch.batchWrite = 0;
 
     // Log a new process started
-    s.Wait();
-    LogItem("PROC ", ossHeader->simClockSeconds,
-        ossHeader->simClockNanoseconds, "Started Successfully", 
+    LOG_AT(LOGLEVEL_INFO, "PROC ", GetSimClock(ossHeader), "Started Successfully", 
         nPid, nItemToProcess, strLogFile);
-    s.Signal();
 
     // Loop forever, the first if statement will handle controlled shutdown
     while(true)
     {
 
         // Set probabilities for this round
-        bool willShutdown = getRandomProbability(0.001f);
-        bool willRead = getRandomProbability(readwriteProbability);
-        bool willReadOutsideLegalPageTable = getRandomProbability(0.001f);
+        bool willShutdown = random.chance(0.001f);
+        bool willRead = random.chance(readwriteProbability);
+        bool willReadOutsideLegalPageTable = random.chance(0.001f);
         
 
 //        cout << "=> " << (rand()%1000)/10.0f << " : " << .001 * 100.0f << endl;
 
         // Every round gets 1-500ms for processing time
-        s.Wait();
-        ossHeader->simClockNanoseconds += getRandomValue(1000, 500000);
-        s.Signal();
+        AdvanceSimClock(ossHeader, random.between(1000, 500000));
 
         // Shut down
         if(sigQuitFlag || willShutdown)
         {
 
 
-            s.Wait();
-            LogItem("PROC ", ossHeader->simClockSeconds,
-                ossHeader->simClockNanoseconds,
+            LOG_AT(LOGLEVEL_INFO, "PROC ", GetSimClock(ossHeader),
                 "Process Shutting Down", 
                 nPid, nItemToProcess, strLogFile);
-            s.Signal();
 
             // Send the message Synchronously - we want it to shutdown
             // all the resources, then exit cleanly
-            msg.type = OSS_MQ_TYPE;
             msg.action = PROCESS_SHUTDOWN;
             msg.procIndex = nItemToProcess;
             msg.procPid = nPid;
-            int n = msgsnd(msgid, (void *) &msg, sizeof(message), IPC_NOWAIT);
+            SendToOss(ossHeader, msgid, msg);
 
             // Once I get the reply back, we can continue to shutdown
-            msgrcv(msgid, (void *) &msg, sizeof(message), nPid, 0); 
+            ReceiveFromOss(ossHeader, msgid, nItemToProcess, nPid, msg);
 
             return EXIT_SUCCESS;
         }
         
         // Request memory
         // Get memory address to request
-        int memAddress = rand() % 32768;
-        // Setup for a bad address
+        uint memAddress = workload.nextAddress();
+        // Setup for a bad address - processSize is under 2^31, so
+        // this can't wrap
         if(willReadOutsideLegalPageTable)
-            memAddress += rand() % 32768;;
-        msg.type = OSS_MQ_TYPE;
-        msg.action = (willRead) ? FRAME_READ : FRAME_WRITE;
-        msg.procIndex = nItemToProcess;
-        msg.procPid = nPid;
-        msg.memoryAddress = memAddress;
-        // Send a memory request
-        int n = msgsnd(msgid, (void *) &msg, sizeof(message), 0);// IPC_NOWAIT);
-        // Once we get the reply back, we can continue
-        msgrcv(msgid, (void *) &msg, sizeof(message), nPid, 0);
+            memAddress += random.below(processSize);
+
+        // Check the TLB first - a hit is timed here, since oss
+        // never sees it
+        const uint64_t nLookupStart = GetWallTimeNS();
+        const uint nGeneration = pcb.tlbGeneration;
+        if(nGeneration != nTlbGeneration)
+        {
+            // oss unmapped one of our pages - flush everything
+            for(int i = 0; i < tlbSize; i++)
+                tlb[i].page = -1;
+            nTlbGeneration = nGeneration;
+        }
+        const int nPage = GetPageNumber(memAddress);
+        TlbEntry& tlbEntry = tlb[nPage % tlbSize];
+        // Writes to a clean page still go to oss so it can set dirty
+        if(ossHeader->tlbEnabled && memAddress < (uint)processSize && tlbEntry.page == nPage
+            && (willRead || tlbEntry.dirty))
+        {
+            // Only a hit if oss hasn't evicted the page since the
+            // flush check
+            if(pcb.tlbGeneration == nGeneration)
+            {
+                // Mark it referenced, like an MMU would.  The frame
+                // table is oss' - it counts the hit from this bit.
+                // Should oss unmap the page right here, the bit lands
+                // on an invalid PTE and is cleared when it is reused
+                pcb.ptable[nPage].setReferenced(true);
+                pcb.tlbHits++;
+                ossHeader->tlbHitLatency[nItemToProcess].record(GetWallTimeNS() - nLookupStart);
+                LOG_AT(LOGLEVEL_TRACE, "PROC ", GetSimClock(ossHeader),
+                    "Memory Found in TLB - Continuing", 
+                    nPid, nItemToProcess, strLogFile);
+                continue;
+            }
+        }
+        pcb.tlbMisses++;
+
+        if(nBatchSize > 1)
+        {
+            // Hold the reference until the batch is full
+            if(!willRead)
+                batch.batchWrite |= 1u << batch.batchCount;
+            batch.batchAddress[batch.batchCount++] = memAddress;
+            if(batch.batchCount < nBatchSize)
+                continue;
+            batch.action = FRAME_BATCH;
+            batch.procIndex = nItemToProcess;
+            batch.procPid = nPid;
+            SendToOss(ossHeader, msgid, batch);
+            ReceiveFromOss(ossHeader, msgid, nItemToProcess, nPid, msg);
+        }
+        else
+        {
+            msg.action = (willRead) ? FRAME_READ : FRAME_WRITE;
+            msg.procIndex = nItemToProcess;
+            msg.procPid = nPid;
+            msg.memoryAddress = memAddress;
+            // Send a memory request
+            SendToOss(ossHeader, msgid, msg);
+            // Once we get the reply back, we can continue
+            ReceiveFromOss(ossHeader, msgid, nItemToProcess, nPid, msg);
+        }
         // Check if OSS is telling it to shutdown
         if(msg.action==PROCESS_SHUTDOWN)
         {
-            s.Wait();
-            LogItem("PROC ", ossHeader->simClockSeconds,
-                ossHeader->simClockNanoseconds,
+            LOG_AT(LOGLEVEL_INFO, "PROC ", GetSimClock(ossHeader),
                 "Memory error - outside valid page table. Shutting down process", 
                 nPid, nItemToProcess, strLogFile);
-            s.Signal();
 
             return EXIT_FAILURE;
         }
 
-        s.Wait();
-        LogItem("PROC ", ossHeader->simClockSeconds,
-            ossHeader->simClockNanoseconds,
-            "Memory Received - Continuing", 
-            nPid, nItemToProcess, strLogFile);
-
-
-
-        // Perform the FIFO Second Chance Page Replacement Algorithm
-        // Find out % total free frames - < 10%
-        int totalFrameFree = 0;
-        for(int i = 0; i < pageCount; i++)
-        {
-            if(!ossHeader->pcb[nItemToProcess].ptable[i].valid)
-                totalFrameFree++;
-        }
-        // Is < 10% Free?
-        if(totalFrameFree < (pageCount / 10 + 1) )
+        if(nBatchSize > 1)
         {
-            LogItem("PROC ", ossHeader->simClockSeconds,
-                ossHeader->simClockNanoseconds,
-                "Running FIFO 2nd Chance Page Replacement Algorithm", 
-                nPid, nItemToProcess, strLogFile);
-
-            // Clear 5% of total frames
-            int FrameToClear = ossHeader->pcb[nItemToProcess].currentFrame;
-            for(int i = 0; i < (pageCount / 5 + 1); i++)
+            // Cache the translations oss sent back.  oss stops at the
+            // first fault, so whatever it didn't get to goes again
+            // at the front of the next batch
+            const int nDone = min(msg.batchCount, batch.batchCount);
+            for(int i = 0; i < nDone; i++)
             {
-                FrameToClear--;
-                if(FrameToClear < 0) FrameToClear = pageCount - 1;
-                // Make invalid if valid
-                if(ossHeader->pcb[nItemToProcess].ptable[i].valid)
-                    ossHeader->pcb[nItemToProcess].ptable[i].valid = 0;
-                else
-                {
-                    // if dirty write it to disk
-                    if(ossHeader->pcb[nItemToProcess].ptable[i].dirty)
-                        ossHeader->simClockNanoseconds += 14000000;
-                    // Clear the entire thing
-                    ossHeader->pcb[nItemToProcess].ptable[i].frame = -1;
-                    ossHeader->pcb[nItemToProcess].ptable[i].reference = 0;
-                    ossHeader->pcb[nItemToProcess].ptable[i].protection = rand() % 2;
-                    ossHeader->pcb[nItemToProcess].ptable[i].dirty = 0;
-                    ossHeader->pcb[nItemToProcess].ptable[i].valid = 0;
-                }
+                TlbEntry& entry = tlb[GetPageNumber(batch.batchAddress[i]) % tlbSize];
+                entry.page = GetPageNumber(batch.batchAddress[i]);
+                entry.frame = GetPageNumber(msg.batchAddress[i]);
+                entry.dirty = (batch.batchWrite >> i) & 1;
             }
+            for(int i = nDone; i < batch.batchCount; i++)
+                batch.batchAddress[i - nDone] = batch.batchAddress[i];
+            batch.batchWrite = (nDone < maxBatchSize) ? batch.batchWrite >> nDone : 0;
+            batch.batchCount -= nDone;
+        }
+        else
+        {
+            // Cache the translation oss sent back
+            tlbEntry.page = nPage;
+            tlbEntry.frame = GetFrameNumber(msg.memoryAddress);
+            tlbEntry.dirty = !willRead;
         }
 
-        s.Signal();
+        LOG_AT(LOGLEVEL_VERBOSE, "PROC ", GetSimClock(ossHeader),
+            "Memory Received - Continuing", 
+            nPid, nItemToProcess, strLogFile);
 
     }
 }
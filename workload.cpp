@@ -0,0 +1,218 @@
+/********************************************
+ * workload - Synthetic reference generators
+ * The generators and the workload spec parser.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * workload .cpp file for project
+ ********************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <sstream>
+#include <algorithm>
+#include "pageTable.h"
+#include "workload.h"
+
+using namespace std;
+
+static const char* workloadNames[WORKLOAD_COUNT] =
+    { "uniform", "zipf", "phase", "seq", "stride", "loop", "mix" };
+
+const char* GetWorkloadName(int type)
+{
+    if(type < 0 || type >= WORKLOAD_COUNT)
+        return "unknown";
+    return workloadNames[type];
+}
+
+static int GetWorkloadType(string strName)
+{
+    for(int i = 0; i < WORKLOAD_COUNT; i++)
+        if(strName == workloadNames[i])
+            return i;
+    return -1;
+}
+
+std::string GetWorkloadNames()
+{
+    return "uniform, zipf[:skew=0.99], phase[:hot=8:len=1000], seq[:run=4],\n"
+           "       stride[:step=4:run=4], loop[:pages=16:run=4], or\n"
+           "       mix[:zipf=n:phase=n:seq=n:stride=n:loop=n:uniform=n]";
+}
+
+bool ParseWorkload(std::string strSpec, WorkloadParams& params)
+{
+    params = WorkloadParams();
+    stringstream ss(strSpec);
+    string strPart;
+    getline(ss, strPart, ':');
+    params.type = GetWorkloadType(strPart);
+    if(params.type < 0)
+        return false;
+
+    while(getline(ss, strPart, ':'))
+    {
+        size_t nEquals = strPart.find('=');
+        if(nEquals == string::npos)
+            return false;
+        string strName = strPart.substr(0, nEquals);
+        float fltValue = atof(strPart.substr(nEquals + 1).c_str());
+        int nValue = (int)fltValue;
+        int nType = GetWorkloadType(strName);
+
+        if(strName == "skew" && fltValue > 0.0f)
+            params.skew = fltValue;
+        else if(strName == "len" && nValue > 0)
+            params.phaseLength = nValue;
+        else if(strName == "hot" && nValue > 0)
+            params.hotPages = nValue;
+        else if(strName == "step" && nValue > 0)
+            params.stride = nValue;
+        else if(strName == "pages" && nValue > 0)
+            params.loopPages = nValue;
+        else if(strName == "run" && nValue > 0)
+            params.runLength = nValue;
+        else if(params.type == WORKLOAD_MIX && nType >= 0 && nType != WORKLOAD_MIX
+            && nValue >= 0)
+            params.weights[nType] = nValue;
+        else
+            return false;
+    }
+
+    // A plain mix is mostly a hot set with some scanning
+    if(params.type == WORKLOAD_MIX)
+    {
+        int nTotal = 0;
+        for(int nWeight : params.weights)
+            nTotal += nWeight;
+        if(nTotal == 0)
+        {
+            params.weights[WORKLOAD_ZIPF] = 40;
+            params.weights[WORKLOAD_PHASE] = 30;
+            params.weights[WORKLOAD_SEQ] = 15;
+            params.weights[WORKLOAD_LOOP] = 15;
+        }
+    }
+    return true;
+}
+
+/***************************************************
+ * workloadGenerator
+ * *************************************************/
+workloadGenerator::workloadGenerator(const WorkloadParams& params, uint64_t seed)
+    : _params(params), _random(seed), _nMixTotal(0)
+{
+    for(int nWeight : _params.weights)
+        _nMixTotal += nWeight;
+    _params.hotPages = min(_params.hotPages, pageCount);
+    _params.loopPages = min(_params.loopPages, pageCount);
+
+    // The Zipf table is the same for every process - only which
+    // page gets which rank differs
+    if(uses(WORKLOAD_ZIPF))
+    {
+        _zipfCdf.resize(pageCount);
+        _zipfPages.resize(pageCount);
+        double fltTotal = 0.0;
+        for(int i = 0; i < pageCount; i++)
+        {
+            fltTotal += 1.0 / pow(i + 1, _params.skew);
+            _zipfCdf[i] = fltTotal;
+        }
+        for(double& fltCdf : _zipfCdf)
+            fltCdf /= fltTotal;
+        for(int i = 0; i < pageCount; i++)
+            _zipfPages[i] = i;
+    }
+    restart();
+}
+
+bool workloadGenerator::uses(int type)
+{
+    return _params.type == type
+        || (_params.type == WORKLOAD_MIX && _params.weights[type] > 0);
+}
+
+void workloadGenerator::restart()
+{
+    // Scatter the hot ranks over the address space
+    for(int i = (int)_zipfPages.size() - 1; i > 0; i--)
+        swap(_zipfPages[i], _zipfPages[_random.below(i + 1)]);
+
+    _nPhaseReferences = 0;
+    _nPhaseBase = _random.below(pageCount);
+    _nLoopBase = _random.below(pageCount);
+    for(Cursor& cursor : _cursors)
+    {
+        cursor.page = _random.below(pageCount);
+        cursor.run = 0;
+    }
+    _cursors[WORKLOAD_LOOP].page = 0;
+}
+
+// walk - seq, stride and loop make runLength references to a page,
+// then step to the next one
+int workloadGenerator::walk(int type)
+{
+    Cursor& cursor = _cursors[type];
+    if(cursor.run++ < _params.runLength)
+        return type == WORKLOAD_LOOP ? (_nLoopBase + cursor.page) % pageCount : cursor.page;
+
+    cursor.run = 1;
+    if(type == WORKLOAD_SEQ)
+        cursor.page = (cursor.page + 1) % pageCount;
+    else if(type == WORKLOAD_STRIDE)
+    {
+        // Start one page further along each time round, so every
+        // page gets visited whatever the stride
+        cursor.page += _params.stride;
+        if(cursor.page >= pageCount)
+            cursor.page = (cursor.page + 1) % pageCount;
+    }
+    else
+    {
+        cursor.page = (cursor.page + 1) % _params.loopPages;
+        return (_nLoopBase + cursor.page) % pageCount;
+    }
+    return cursor.page;
+}
+
+int workloadGenerator::nextPage(int type)
+{
+    switch(type)
+    {
+        case WORKLOAD_ZIPF:
+        {
+            int nRank = lower_bound(_zipfCdf.begin(), _zipfCdf.end(), _random.unit())
+                - _zipfCdf.begin();
+            return _zipfPages[min(nRank, pageCount - 1)];
+        }
+        case WORKLOAD_PHASE:
+            if(++_nPhaseReferences > _params.phaseLength)
+            {
+                _nPhaseReferences = 1;
+                _nPhaseBase = _random.below(pageCount);
+            }
+            return (_nPhaseBase + _random.below(_params.hotPages)) % pageCount;
+        case WORKLOAD_SEQ:
+        case WORKLOAD_STRIDE:
+        case WORKLOAD_LOOP:
+            return walk(type);
+        case WORKLOAD_MIX:
+        {
+            int nPick = _random.below(_nMixTotal);
+            int nType = 0;
+            while(nPick >= _params.weights[nType])
+                nPick -= _params.weights[nType++];
+            return nextPage(nType);
+        }
+        default:
+            return _random.below(pageCount);
+    }
+}
+
+unsigned int workloadGenerator::nextAddress()
+{
+    return ((unsigned int)nextPage(_params.type) << pageShift) + _random.below(pageSize);
+}
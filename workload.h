@@ -0,0 +1,144 @@
+/********************************************
+ * workload - Synthetic reference generators
+ * Picks the virtual addresses a simulated
+ * process touches.  Besides the original
+ * uniform picks there are Zipfian hot sets,
+ * working sets that shift in phases, sequential
+ * scans, strided and looping walks, and
+ * weighted mixes of them, so replacement
+ * policies see the locality real programs have.
+ * Each process has its own fast PRNG.
+ * (c)2021 Brett Huffman
+ *
+ * Brett Huffman
+ * workload .h file for project
+ ********************************************/
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+enum WorkloadType {
+    WORKLOAD_UNIFORM,   // Any page, any offset - no locality
+    WORKLOAD_ZIPF,      // Page ranks follow a Zipf distribution
+    WORKLOAD_PHASE,     // Uniform over a small working set that moves every phase
+    WORKLOAD_SEQ,       // Page after page, wrapping at the end
+    WORKLOAD_STRIDE,    // Every stride'th page
+    WORKLOAD_LOOP,      // Round and round the same few pages
+    WORKLOAD_MIX,       // Each reference picks one of the above by weight
+    WORKLOAD_COUNT
+};
+
+// A workload and its settings.  Trivially copyable - oss hands it
+// to user_proc in the shared memory header
+struct WorkloadParams {
+    int type = WORKLOAD_UNIFORM;
+    float skew = 0.99f;         // zipf - exponent, higher is more skewed
+    int phaseLength = 1000;     // phase - references before the working set moves
+    int hotPages = 8;           // phase - pages in the working set
+    int stride = 4;             // stride - pages between references
+    int loopPages = 16;         // loop - pages in the loop
+    int runLength = 4;          // seq/stride/loop - references to a page before moving on
+    int weights[WORKLOAD_COUNT] = {};   // mix - weight of each type
+};
+
+// Parses name[:key=value...], e.g. zipf:skew=1.2, phase:hot=16:len=5000
+// or mix:zipf=60:seq=20:loop=20:pages=64.  A mix takes the weights
+// and the settings of its parts.  Returns false if it is not valid
+bool ParseWorkload(std::string, WorkloadParams&);
+
+// Name of a workload type
+const char* GetWorkloadName(int);
+
+// Names and settings, for usage messages
+std::string GetWorkloadNames();
+
+/***************************************************
+ * workloadRandom - xorshift64* generator.  Much
+ * cheaper than rand() and each process has its
+ * own, so there is no shared state
+ * *************************************************/
+class workloadRandom
+{
+    private:
+        uint64_t _state;
+
+    public:
+
+    workloadRandom(uint64_t seed = 1) { setSeed(seed); }
+
+    // splitmix64 spreads out similar seeds like pids.  The state
+    // must never be 0
+    void setSeed(uint64_t seed)
+    {
+        uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        _state = (z ^ (z >> 31)) | 1;
+    }
+
+    uint64_t next()
+    {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return _state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // 0 to nRange-1, by multiply and shift instead of modulo
+    uint32_t below(uint32_t nRange) { return ((next() >> 32) * nRange) >> 32; }
+
+    // nMin to nMax inclusive
+    int between(int nMin, int nMax) { return nMin + below(nMax - nMin + 1); }
+
+    // [0, 1)
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    bool chance(float fProbability) { return unit() < fProbability; }
+};
+
+/***************************************************
+ * workloadGenerator - One process' reference
+ * stream.  The memory geometry must be set
+ * before one is made
+ * *************************************************/
+class workloadGenerator
+{
+    private:
+        // Where a seq, stride or loop walk is up to
+        struct Cursor {
+            int page;
+            int run;        // References made to page so far
+        };
+
+        WorkloadParams _params;
+        workloadRandom _random;
+        std::vector<double> _zipfCdf;   // Chance of rank <= i
+        std::vector<int> _zipfPages;    // Page holding each rank
+        int _nMixTotal;
+        long _nPhaseReferences;
+        int _nPhaseBase;
+        int _nLoopBase;
+        Cursor _cursors[WORKLOAD_COUNT];
+
+        bool uses(int type);
+        int nextPage(int type);
+        int walk(int type);
+
+    public:
+
+    workloadGenerator(const WorkloadParams&, uint64_t seed);
+
+    // A new process takes over - new hot pages and walk positions
+    void restart();
+
+    // Next virtual address, 0 to processSize-1
+    unsigned int nextAddress();
+
+    // The same generator, for the process' other random choices
+    workloadRandom& random() { return _random; }
+};
+
+#endif // WORKLOAD_H